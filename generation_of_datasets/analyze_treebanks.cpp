@@ -29,6 +29,7 @@
  *          
  *******************************************************************************/#include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -38,48 +39,74 @@
 #include <string>
 #include <string.h>
 #include <limits>
+#include <memory>
 #include <algorithm>
 #include <filesystem>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <dirent.h>
 #include "probability_of_crossing_knowing_edge_lengths.hpp"
 #include "fast_prediction_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "sampling_of_crossings_at_constant_sum_of_lengths.hpp"
 #include "undirected_graph.hpp"
+#include "treebank_view.hpp"
+#include "heads_file.hpp"
+#include "thread_pool.hpp"
+#include "running_statistics.hpp"
+#include "dependency_tree.hpp"
+#include "tree_metrics.hpp"
+#include "buffered_writer.hpp"
+#include "metrics_file.hpp"
+#include "treebank_cache.hpp"
+#include "scratch_arena.hpp"
 
 using namespace std;
 
 const double numerical_error = 1e-10;
 
+//trees whose metrics are computed in parallel before adding them to the statistics
+const std::size_t trees_per_block = 4096;
+
 void calculate(const string &label, const undirected_graph &g);
 
 //metrics on crossings
-void compute_metrics ( std::vector<undirected_graph> graphs );
-void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix = "" , bool verbose = true , bool c_d = false );
-void compute_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup , bool verbose = true , bool c_d = false , const std::string& linePrefix = "" );
+void compute_metrics ( const treebank_view &graphs , std::ostream& out = cout );
+void compute_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix = "" , bool verbose = true , bool c_d = false , std::ostream& out = cout , std::ostream* intervals = NULL , const std::string& language = "" , unsigned long long file_seed = 0 );
+void compute_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup , bool verbose = true , bool c_d = false , const std::string& linePrefix = "" , std::ostream& out = cout , std::ostream* intervals = NULL , const std::string& language = "" , unsigned long long file_seed = 0 );
 
 //main template methods to call the other methods
-void process_heads_file ( const char * heads_file_name );
+std::unique_ptr<heads_source> open_heads_file ( const char * heads_file_name );
+void process_heads_file ( const char * heads_file_name , std::ostream& out = cout , std::ostream& table_out = cout , metrics_table * binary_table = NULL );
+void process_heads_file_streaming ( const char * heads_file_name , std::ostream& out = cout , std::ostream& table_out = cout , metrics_table * binary_table = NULL );
 void process_heads_file_incrementally ( const char * heads_file_name , const char * output_file_name );
 
 //utilities
-double overflow_safe_average ( std::vector<double> myvector );
-std::vector<undirected_graph> length_filter ( std::vector<undirected_graph> input , int min_length , int max_length );
+treebank_view length_filter ( const treebank_view &input , int min_length , int max_length );
 std::string get_iso_code ( std::string language_or_filename );
 int ends_with(const char *str, const char *suffix);
+unsigned long long file_name_seed ( const std::string& file_name );
 std::vector<std::string> get_files ( const char * directory , const char * extension );
 
 //omega (optimality) metrics
-void compute_optimality_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix = "" , bool verbose = true );
-void compute_grammar_optimality_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix , bool verbose = true );
-void compute_optimality_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup , bool verbose = true , const std::string& linePrefix = ""  );
-void compute_grammar_optimality_by_lengths ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup  , bool verbose = true , const std::string& linePrefix =""  );
-void output_individual_omegas_to_file ( std::vector<undirected_graph> graphs , char * filename );
-void output_individual_grammar_optimality_metrics_to_file( ofstream& output_stream , undirected_graph& mygraph );
+void compute_optimality_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix = "" , bool verbose = true , std::ostream& out = cout );
+void compute_grammar_optimality_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix , bool verbose = true , std::ostream& out = cout );
+void compute_optimality_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup , bool verbose = true , const std::string& linePrefix = "" , std::ostream& out = cout );
+void compute_grammar_optimality_by_lengths ( const treebank_view &graphs , std::size_t minAmountPerGroup  , bool verbose = true , const std::string& linePrefix ="" , std::ostream& out = cout );
+std::vector<tree_metrics> individual_metrics ( const treebank_view &graphs , unsigned features );
+std::vector<tree_metrics> individual_metrics ( const std::vector<dependency_tree> &trees , unsigned features );
+void output_individual_omegas_to_file ( const treebank_view &graphs , char * filename , std::ostream& out = cout );
+void output_individual_omegas_to_file ( const std::vector<tree_metrics> &metrics , char * filename , std::ostream& out = cout );
+void output_optimality_statistics ( const running_statistics &length , const running_statistics &D , const running_statistics &D_min , const running_statistics &D_random , const running_statistics &Omega , const std::string& linePrefix , bool verbose , std::ostream& out );
+void output_individual_grammar_optimality_metrics_to_file( buffered_writer& output_stream , const undirected_graph& mygraph );
 
 //anti-dlm metrics
-void compute_antidlm_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix = "" , bool verbose = true );
-void compute_antidlm_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup , bool verbose = true , const std::string& linePrefix = ""  );
-void output_individual_antidlm_metrics_to_file ( std::vector<undirected_graph> graphs , const char * filename , const std::string& linePrefix = "" , bool append = false );
+void compute_antidlm_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix = "" , bool verbose = true , std::ostream& out = cout );
+void compute_antidlm_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup , bool verbose = true , const std::string& linePrefix = "" , std::ostream& out = cout );
+void output_individual_antidlm_metrics_to_file ( const treebank_view &graphs , const char * filename , const std::string& linePrefix = "" , bool append = false , std::ostream& out = cout );
+void output_individual_antidlm_header ( std::ostream& output_stream , bool language );
+void output_individual_antidlm_metrics ( const treebank_view &graphs , std::ostream& output_stream , const std::string& linePrefix = "" );
+void output_individual_antidlm_metrics ( const std::vector<tree_metrics> &metrics , std::ostream& output_stream , const std::string& linePrefix = "" );
+void output_individual_antidlm_metrics ( const std::vector<tree_metrics> &metrics , metrics_table& table , const std::string& language );
 
 
 
@@ -96,41 +123,169 @@ void output_individual_antidlm_metrics_to_file ( std::vector<undirected_graph> g
 
   //command to execute
   std::string command = "individual_table";
+
+  //binary file with the tables of probabilities of crossing, loaded at startup and updated at exit (option --crossing-tables)
+  std::string crossing_tables_file = std::string("");
+
+  //read, process and discard the trees of each file one block at a time (option --stream)
+  bool stream = false;
+
+  //with --stream, estimate medians with a sketch of this size instead of keeping every value (option --median-sketch)
+  median_method stream_median = exact_median;
+  int median_sketch_size = 256;
+
+  //individual_table and omega_files write binary columnar metrics files instead of text (option --binary)
+  bool binary_output = false;
+
+  //read the trees of every heads file from a binary cache next to it, written the first time (option --cache)
+  bool use_cache = false;
+
+  //crossings_table and crossings_by_length_groups also compute E[C|D], the expected crossings at constant sum of edge lengths (option --cd)
+  bool constant_D = false;
+
+  //with --cd, E[C|D] is enumerated for trees of up to this many vertices and sampled for longer ones (option --cd-exact)
+  int c_d_exact_vertices = 10;
+
+  //sample budget and target standard error of the sampled E[C|D] (options --cd-samples and --cd-standard-error)
+  crossings_sampling c_d_sampling;
+
+  //the sampling of E[C|D] of a tree is seeded with c_d_seed, the name of its file and its position in the file (option --cd-seed)
+  unsigned long long c_d_seed = 0;
+
+  //with --cd, the E[C|D] of every tree and its 95% confidence interval are written to outfile (option --cd-intervals)
+  bool c_d_intervals = false;
   
 
 
 int main( int argc , char * argv[] )
 {
   
-     //process arguments
-     std::vector<std::string> args(argv, argv+argc);
-     if ( argc > 1 )
+     //process arguments: options (--name value) can go anywhere, the rest are positional
+     std::vector<std::string> args;
+     for ( int i = 1 ; i < argc ; i++ )
      {
-        command = argv[1];
+        if ( std::string(argv[i]) == "--crossing-tables" && i+1 < argc )
+            crossing_tables_file = argv[++i];
+        else if ( std::string(argv[i]) == "--cache" )
+            use_cache = true;
+        else if ( std::string(argv[i]) == "--binary" )
+            binary_output = true;
+        else if ( std::string(argv[i]) == "--stream" )
+            stream = true;
+        else if ( std::string(argv[i]) == "--median-sketch" && i+1 < argc )
+        {
+            stream_median = sketched_median;
+            median_sketch_size = std::max(2,atoi(argv[++i]));
+        }
+        else if ( std::string(argv[i]) == "--threads" && i+1 < argc )
+            set_threads(std::max(1,atoi(argv[++i])));
+        else if ( std::string(argv[i]) == "--verify-crossing-tables" && i+1 < argc )
+            probability_of_crossing_knowing_edge_lengths::set_verification_bound(atoi(argv[++i]));
+        else if ( std::string(argv[i]) == "--cd" )
+            constant_D = true;
+        else if ( std::string(argv[i]) == "--cd-exact" && i+1 < argc )
+            c_d_exact_vertices = atoi(argv[++i]);
+        else if ( std::string(argv[i]) == "--cd-samples" && i+1 < argc )
+        {
+            c_d_sampling.max_samples = std::max(1LL,atoll(argv[++i]));
+            c_d_sampling.min_samples = std::min(c_d_sampling.min_samples,c_d_sampling.max_samples);
+        }
+        else if ( std::string(argv[i]) == "--cd-standard-error" && i+1 < argc )
+            c_d_sampling.standard_error = atof(argv[++i]);
+        else if ( std::string(argv[i]) == "--cd-seed" && i+1 < argc )
+            c_d_seed = strtoull(argv[++i],NULL,10);
+        else if ( std::string(argv[i]) == "--cd-intervals" )
+            c_d_intervals = true;
+        else
+            args.push_back(argv[i]);
+     }
+     if ( args.size() > 0 )
+     {
+        command = args[0];
      }
-     if ( argc > 2 )
+     if ( args.size() > 1 )
      {
-         directory = argv[2];
+         directory = args[1];
      }
-     if ( argc > 3 )
+     if ( args.size() > 2 )
      {
-         extension = argv[3];
+         extension = args[2];
      }
-     if ( argc > 4 )
+     if ( args.size() > 3 )
      {
-         outfile = argv[4];
+         outfile = args[3];
      }
 
+    int loaded_crossing_tables = 0;
+    if ( !crossing_tables_file.empty() )
+        loaded_crossing_tables = read_probability_of_crossing_tables(crossing_tables_file.c_str());
+
    
   //int sz = sizeof(files) / sizeof(const char *);
 
     std::vector<std::string> filenames = get_files(directory.c_str(),extension.c_str());
 
-    for ( std::vector<std::string> :: iterator it = filenames.begin(); it != filenames.end(); ++it )
+    //individual_table appends the lines of every file to outfile, after a single header;
+    //with --binary, the rows of every file are collected and outfile is rewritten as a metrics file at the end
+    bool binary_table = ( command == "individual_table" && binary_output );
+    metrics_table table( column_n | column_K2 | column_D | column_D_min | column_language );
+    std::ofstream table_stream;
+    if ( command == "individual_table" && !filenames.empty() && !binary_table )
     {
-        process_heads_file((*it).c_str());
+        table_stream.open(outfile.c_str(), std::ofstream::out | std::ofstream::app );
+        output_individual_antidlm_header( table_stream , true );
+    }
+    //with --cd-intervals, crossings_table and crossings_by_length_groups write the E[C|D] of every tree to outfile
+    bool crossings_command = ( command == "crossings_table" || command == "crossings_by_length_groups" );
+    if ( crossings_command && constant_D && c_d_intervals && !filenames.empty() )
+    {
+        table_stream.open(outfile.c_str(), std::ofstream::out | std::ofstream::app );
+        table_stream << "language n D C E[C|D] lower upper samples" << endl;
     }
 
+    //files are processed in parallel, but their output is buffered and written in the order of the files
+    std::size_t files = filenames.size();
+    std::vector<std::ostringstream> file_out(files);
+    std::vector<std::ostringstream> file_table_out(files);
+    std::vector<metrics_table> file_table( binary_table ? files : 0 , metrics_table(table.columns) );
+    std::vector< std::unique_ptr<task_group> > file_done(files);
+    auto write_file_output = [&] ( std::size_t i )
+    {
+        file_done[i]->wait();
+        cout << file_out[i].str();
+        table_stream << file_table_out[i].str();
+        file_out[i].str("");
+        file_table_out[i].str("");
+        if ( binary_table )
+        {
+            table.append(file_table[i]);
+            file_table[i] = metrics_table(table.columns);
+        }
+    };
+    //in streaming mode the files go one after the other, straight to the output, so that nothing is buffered
+    if ( stream && !crossings_command )
+    {
+        for ( std::size_t i = 0 ; i < files ; i++ )
+            process_heads_file_streaming( filenames[i].c_str() , cout , table_stream , binary_table ? &table : NULL );
+        files = 0;
+    }
+    for ( std::size_t i = 0 ; i < files ; i++ )
+    {
+        file_done[i].reset( new task_group(default_thread_pool()) );
+        file_done[i]->run( [&,i] { process_heads_file( filenames[i].c_str() , file_out[i] , file_table_out[i] , binary_table ? &file_table[i] : NULL ); } );
+        //without a pool the file has just been processed
+        if ( default_thread_pool() == NULL ) write_file_output(i);
+    }
+    if ( default_thread_pool() != NULL )
+        for ( std::size_t i = 0 ; i < files ; i++ ) write_file_output(i);
+    table_stream.close();
+    if ( binary_table && !filenames.empty() && !write_metrics_file( outfile.c_str() , table ) )
+        std::cerr << "Problem with " << outfile << endl;
+
+    //only rewrite the tables file if new tables that can be saved were built in this run
+    if ( !crossing_tables_file.empty() && cached_probability_of_crossing_tables() > loaded_crossing_tables )
+        write_probability_of_crossing_tables(crossing_tables_file.c_str());
+
 
 }
 
@@ -145,53 +300,67 @@ char * output_file_name ( const char * input_file_name )
 	return copy;
 }
 
+std::unique_ptr<heads_source> open_heads_file ( const char * heads_file_name )
+//the trees of a heads file; with --cache, from heads_file_name.cache, which is (re)written from the text when it is missing or older
+{
+  if ( use_cache )
+  {
+    std::string cache_file_name = std::string(heads_file_name) + ".cache";
+    struct stat heads_info , cache_info;
+    bool fresh = ( stat( cache_file_name.c_str() , &cache_info ) == 0 &&
+                   ( stat( heads_file_name , &heads_info ) != 0 || cache_info.st_mtime >= heads_info.st_mtime ) );
+    if ( !fresh )
+    {
+      heads_file text(heads_file_name);
+      if ( text.good() )
+      {
+        std::vector<int> heads;
+        std::vector<std::size_t> offset;
+        text.read_trees( heads , offset );
+        if ( !write_treebank_cache( cache_file_name.c_str() , treebank_id(heads_file_name) , heads , offset ) )
+          std::cerr << "Problem with " << cache_file_name << endl;
+      }
+    }
+    std::unique_ptr<heads_source> cache( new treebank_cache( cache_file_name.c_str() ) );
+    if ( cache->good() )
+      return cache;
+  }
+  return std::unique_ptr<heads_source>( new heads_file(heads_file_name) );
+}
+
 void process_heads_file_incrementally ( const char * heads_file_name , const char * output_file_name ) //for very large files where we can't put all trees into a vector
 {
   //open the heads file:
-  std::ifstream heads_stream(heads_file_name);
-  if ( !heads_stream )
+  std::unique_ptr<heads_source> heads_stream = open_heads_file(heads_file_name);
+  if ( !heads_stream->good() )
   std::cerr << "Problem with " << heads_file_name << endl;
-  std::string line;
   std::vector<int> current_tree;
   
   //open the output file:
-  //this should set max precision
-  ofstream output_stream;
-  output_stream.open(output_file_name);
-  //17 (digits10+2) is "the minimum number of digits needed to survive a round-trip to string form and back and get the same double in the end."
-  output_stream << setprecision(numeric_limits<double>::digits10 + 2);
+  //the writer uses the shortest form of each double that reads back as the same double
+  ofstream output_file;
+  output_file.open(output_file_name);
+  buffered_writer output_stream(output_file);
   
   //read one tree per line and build undirected_graph
-  while ( getline( heads_stream , line ) ) 
+  while ( heads_stream->read_tree( current_tree ) ) 
   {
-    std::istringstream is( line );
-    current_tree = 
-    std::vector<int>( std::istream_iterator<int>(is),
-                        std::istream_iterator<int>() );
-    undirected_graph mygraph(current_tree.size());
-    //cout << "Creating graph with size " << current_tree.size() << endl; //debug info
-    for ( unsigned int i = 0 ; i < current_tree.size() ; i++ ) 
-    {
-      int dependent = i;
-      int head = current_tree[i] - 1;
-      if ( head >= 0 ) 
-      { //if head is -1 (0 was in the file), node is the sentence root
-        int min = (dependent<head)?dependent:head;
-        int max = (dependent>head)?dependent:head;
-        mygraph.add_edge(min,max);
-        //cout << "Adding edge: " << min << " " << max << endl; //debug info
-      }
-    }
+    //a head of 0 in the file marks the sentence root, which gets no edge
+    undirected_graph mygraph(current_tree);
     //assert: mygraph is now an undirected_graph from the file
     
     //here we work with the graph
     output_individual_grammar_optimality_metrics_to_file(output_stream,mygraph);
+    current_tree.clear();
   }
   
-  output_stream.close();
+  output_stream.flush();
+  output_file.close();
 }
 
-void process_heads_file ( const char * heads_file_name )
+void process_heads_file ( const char * heads_file_name , std::ostream& out /*= cout*/ , std::ostream& table_out /*= cout*/ , metrics_table * binary_table /*= NULL*/ )
+//out receives what is shown on screen, table_out the lines of the individual table (without header),
+//or binary_table its rows if it is not NULL
 {
 
   //cout << "Processing file: " << heads_file_name << endl;
@@ -200,43 +369,45 @@ void process_heads_file ( const char * heads_file_name )
   //cout << heads_file_name << endl; //" ";
 
   //open the heads file:
-  std::ifstream heads_stream(heads_file_name);
-  if ( !heads_stream )
+  std::unique_ptr<heads_source> heads_stream = open_heads_file(heads_file_name);
+  if ( !heads_stream->good() )
     std::cerr << "Problem with " << heads_file_name << endl;
-  std::string line;
-  std::vector< std::vector<int> > my_heads;
 
-  //read one tree per line into the vector of vectors:
-  while ( getline( heads_stream , line ) ) 
+  //read one tree per line: the heads of tree t are my_heads[offset[t]], ..., my_heads[offset[t+1]-1]
+  std::vector<int> my_heads;
+  std::vector<std::size_t> offset;
+  heads_stream->read_trees( my_heads , offset );
+
+  //individual_table and omega_files work on the heads directly, without building any graph
+  if ( command == "individual_table" || command == "omega_files" )
   {
-    std::istringstream is( line );
-    my_heads.push_back(
-      std::vector<int>( std::istream_iterator<int>(is),
-                        std::istream_iterator<int>() ) );
+    std::vector<dependency_tree> trees;
+    trees.reserve( offset.size() - 1 );
+    for ( std::size_t t = 0 ; t + 1 < offset.size() ; t++ )
+      trees.push_back( dependency_tree( my_heads.data() + offset[t] , int(offset[t+1] - offset[t]) ) );
+    if ( command == "individual_table" ) //antidlm, the header and the file are handled by main
+    {
+      out << "Outputting to file: " << outfile << endl;
+      std::vector<tree_metrics> metrics = individual_metrics( trees , metric_K2 | metric_D | metric_D_min );
+      if ( binary_table != NULL )
+        output_individual_antidlm_metrics( metrics , *binary_table , get_iso_code(heads_file_name) );
+      else
+        output_individual_antidlm_metrics( metrics , table_out , get_iso_code(heads_file_name) );
+    }
+    else //.omegas files for Monte Carlo
+      output_individual_omegas_to_file( individual_metrics( trees , metric_Omega ) , output_file_name(heads_file_name) , out );
+    return;
   }
 
-  std::vector< undirected_graph > graphs;
-
-  for( std::vector< std::vector<int> >::iterator it = my_heads.begin() ; it != my_heads.end() ; ++it ) {
-    std::vector<int> current_tree = *it;
+  std::vector< undirected_graph > graphs( offset.size() - 1 );
 
-    undirected_graph mygraph(current_tree.size());
-    //cout << "Creating graph with size " << current_tree.size() << endl; //debug info
-    for ( unsigned int i = 0 ; i < current_tree.size() ; i++ ) 
-    {
-      int dependent = i;
-      int head = current_tree[i] - 1;
-      if ( head >= 0 ) 
-      { //if head is -1 (0 was in the file), node is the sentence root
-        int min = (dependent<head)?dependent:head;
-        int max = (dependent>head)?dependent:head;
-        mygraph.add_edge(min,max);
-        //cout << "Adding edge: " << min << " " << max << endl; //debug info
-      }
-    }
-    graphs.push_back( mygraph );
-    //calculate ( "Test "  , mygraph );
+  parallel_for ( graphs.size() , 256 , [&] ( std::size_t begin , std::size_t end ) {
+  for( std::size_t t = begin ; t < end ; ++t ) {
+    //a head of 0 in the file marks the sentence root, which gets no edge
+    graphs[t] = undirected_graph( my_heads.data() + offset[t] , int(offset[t+1] - offset[t]) );
+    //calculate ( "Test "  , graphs[t] );
   }
+  } );
   
   //PROCESS THE VECTOR OF GRAPHS HERE
 
@@ -264,41 +435,43 @@ void process_heads_file ( const char * heads_file_name )
   //compute_grammar_optimality_by_lengths ( graphs , 1  , false , string(heads_file_name).substr(string(heads_file_name).find_last_of("/\\")+1,3)  );
   //output_individual_antidlm_metrics_to_file( graphs , outfile.c_str() /*"antidlm-ud25-all-shuffled.txt"*/ /*"antidlm-sud25-all.txt"*/ /*"antidlm-proiel-all.txt"*/ /*"antidlm-pud-all.txt"*/ /*"antidlm-ud25-all2.txt"*/ /*"antidlm-ud24-all.txt"*/ /*"antidlm-all-languages-all-fixed.txt"*/ , get_iso_code(heads_file_name) , true );
   if ( command == "global_optimality_table") //not currently used much
-    compute_optimality_detailed_metrics( graphs , heads_file_name , false );
+    compute_optimality_detailed_metrics( graphs , heads_file_name , false , out );
   else if ( command == "optimality_by_length_groups") //not currently used much
-    compute_optimality_by_length_groups(graphs,1,false,string(heads_file_name)+string("\n"));
-  else if ( command == "individual_table") //antidlm
-    output_individual_antidlm_metrics_to_file( graphs , outfile.c_str() , get_iso_code(heads_file_name) , true );
-  else if ( command == "omega_files" ) //.omegas files for Monte Carlo
-    output_individual_omegas_to_file( graphs , output_file_name(heads_file_name) );
+    compute_optimality_by_length_groups(graphs,1,false,string(heads_file_name)+string("\n"),out);
+  else if ( command == "crossings_table" ) //crossings are possible from 4 vertices on, as in crossings_by_length_groups
+  {
+    treebank_view long_enough = length_filter( graphs , 4 , std::numeric_limits<int>::max() );
+    if ( long_enough.size() == 0 ) //no row, as for the empty groups of crossings_by_length_groups
+      std::cerr << heads_file_name << ": no sentences of at least 4 words" << endl;
+    else
+      compute_detailed_metrics( long_enough , heads_file_name , false , constant_D , out , c_d_intervals ? &table_out : NULL , get_iso_code(heads_file_name) , file_name_seed(heads_file_name) );
+  }
+  else if ( command == "crossings_by_length_groups" )
+    compute_by_length_groups( graphs , 1 , false , constant_D , heads_file_name , out , c_d_intervals ? &table_out : NULL , get_iso_code(heads_file_name) , file_name_seed(heads_file_name) );
   else
-    cout << "Unknown command " << command << endl;
+    out << "Unknown command " << command << endl;
 
 }
 
 
-void output_individual_grammar_optimality_metrics_to_file( ofstream& output_stream , undirected_graph& mygraph )
+void output_individual_grammar_optimality_metrics_to_file( buffered_writer& output_stream , const undirected_graph& mygraph )
 {
-    //bool invalid_length_for_omega = false;
-    int n = mygraph.vertices();
-    //if ( n < 3 ) invalid_length_for_omega = true;
-    double length = double(n);
+    //Omega is not a number if n < 3
+    tree_metrics m = compute_tree_metrics( mygraph , metric_K2 | metric_C | metric_Omega );
+    double length = double(m.n);
 
-    double D = mygraph.edge_length_sum();
-    double Dmin = mygraph.minimum_edge_length_sum_of_a_tree();
-    double Drandom = (n-1)*(n+1)/double(3);
-    double Omega;
+    double D = m.D;
+    double Omega = m.Omega;
 
-    if ( n >= 3 )
+    if ( m.n >= 3 )
     {
-        Omega = (Drandom- D)/(Drandom - Dmin);
         assert(-8 <= Omega);
         assert(Omega <= 1);
     }
     
-    double K2 = mygraph.sum_of_squared_degrees();
-    double crossings = double(mygraph.crossings());
-    output_stream << length << " " << crossings << " " << D << " " << K2 << " " << Omega << endl;
+    double K2 = m.K2;
+    double crossings = double(m.C);
+    output_stream << length << ' ' << crossings << ' ' << D << ' ' << K2 << ' ' << Omega << '\n';
 }
 
 /**
@@ -307,47 +480,245 @@ void output_individual_grammar_optimality_metrics_to_file( ofstream& output_stre
  * @param graphs
  * @param filename
  */
-void output_individual_omegas_to_file ( std::vector<undirected_graph> graphs , char * filename )
+/**
+ * Statistics of the omega metrics of a set of trees, fed one tree at a time (used by --stream).
+ */
+struct optimality_statistics
 {
-	cout << "Outputting to file: " << filename << endl;
-	
-	std::size_t sz = graphs.size();
-
-	//vectors of metrics for each tree. Aren't really needed here (as we can just output in each iterations without storing them)
-	//but who knows.
-	std::vector<double> length = std::vector<double>(sz,0.0);
-	std::vector<double> D = std::vector<double>(sz,0.0);
-	std::vector<double> D_min = std::vector<double>(sz,0.0);
-	std::vector<double> D_random = std::vector<double>(sz,0.0);
-	std::vector<double> Omega = std::vector<double>(sz,0.0);
-  
-  	//this should set max precision
-	ofstream output_stream;
-	output_stream.open(filename);
-	
-	//apparently 17 (digits10+2) is "the minimum number of digits needed to survive a round-trip to string form and back and get the same double in the end."
-	output_stream << setprecision(numeric_limits<double>::digits10 + 2);
-  
-	for ( std::size_t i = 0 ; i < sz ; i++ ) 
-	{
-		undirected_graph graph = graphs[i];
+  running_statistics length , D , D_min , D_random , Omega;
 
-		//process graph
-		int n = graph.vertices();
-		length[i] = double(n);
+  optimality_statistics ( )
+  : length(stream_median,median_sketch_size) , D(stream_median,median_sketch_size) , D_min(stream_median,median_sketch_size) ,
+    D_random(stream_median,median_sketch_size) , Omega(stream_median,median_sketch_size) { }
 
-		D[i] = graph.edge_length_sum();
-		D_min[i] = graph.minimum_edge_length_sum_of_a_tree();
-		D_random[i] = (n-1)*(n+1)/double(3);
-		Omega[i] = (D_random[i] - D[i])/(D_random[i] - D_min[i]);
+  void insert ( double n , double d , double d_min , double d_random , double omega )
+  {
+    length.insert(n); D.insert(d); D_min.insert(d_min); D_random.insert(d_random); Omega.insert(omega);
+  }
+
+  void merge ( const optimality_statistics &s )
+  {
+    length.merge(s.length); D.merge(s.D); D_min.merge(s.D_min); D_random.merge(s.D_random); Omega.merge(s.Omega);
+  }
+};
 
-		output_stream << length[i] << " " << D[i] << " " << D_min[i] << " " << D_random[i] << " " << Omega[i] << endl;
+void process_heads_file_streaming ( const char * heads_file_name , std::ostream& out /*= cout*/ , std::ostream& table_out /*= cout*/ , metrics_table * binary_table /*= NULL*/ )
+//same output as process_heads_file, but the trees are read, processed and discarded one block at a time,
+//so the memory used does not depend on the size of the treebank (except for exact medians, see --median-sketch)
+{
+  std::unique_ptr<heads_source> heads_stream = open_heads_file(heads_file_name);
+  if ( !heads_stream->good() )
+    std::cerr << "Problem with " << heads_file_name << endl;
+
+  bool individual = ( command == "individual_table" );
+  bool omegas = ( command == "omega_files" );
+  bool global = ( command == "global_optimality_table" );
+  bool by_length = ( command == "optimality_by_length_groups" );
+  if ( !individual && !omegas && !global && !by_length )
+  {
+    out << "Unknown command " << command << endl;
+    return;
+  }
+
+  //the per-tree rows go through writers, which use the shortest form of each double that reads back as the same double
+  std::string iso_code;
+  uint16_t language = 0;
+  if ( individual )
+  {
+    out << "Outputting to file: " << outfile << endl;
+    iso_code = get_iso_code(heads_file_name);
+    if ( binary_table != NULL ) language = binary_table->language_id(iso_code);
+  }
+  buffered_writer table_writer(table_out);
+  ofstream omegas_file;
+  std::string omegas_file_name;
+  metrics_table omegas_table( column_n | column_D | column_D_min | column_Omega );
+  if ( omegas )
+  {
+    char * filename = output_file_name(heads_file_name);
+    omegas_file_name = binary_output ? std::string(filename) + ".bin" : std::string(filename);
+    out << "Outputting to file: " << omegas_file_name << endl;
+    if ( !binary_output ) omegas_file.open(filename);
+    free(filename);
+  }
+  buffered_writer omegas_stream(omegas_file);
+  optimality_statistics all;
+  std::vector<optimality_statistics> of_length; //of_length[n]: trees of n vertices
+
+  //the heads of tree t of the block are heads[offset[t]], ..., heads[offset[t+1]-1]
+  std::vector<int> heads;
+  std::vector<std::size_t> offset;
+  std::vector<tree_metrics> metrics(trees_per_block);
+#ifdef COUNT_ALLOCATIONS
+  std::size_t total_trees = 0;
+  long long metric_allocations = 0;
+#endif
+  bool more = true;
+  while ( more )
+  {
+    heads.clear();
+    offset.assign(1,0);
+    while ( offset.size() <= trees_per_block && ( more = heads_stream->read_tree(heads) ) )
+      offset.push_back(heads.size());
+    std::size_t trees = offset.size() - 1;
+
+#ifdef COUNT_ALLOCATIONS
+    long long allocations_before = allocation_count();
+#endif
+    parallel_for ( trees , 16 , [&] ( std::size_t begin , std::size_t end ) {
+    for ( std::size_t t = begin ; t < end ; t++ )
+    {
+      //the metrics straight from the heads, without building the graph
+      metrics[t] = compute_tree_metrics( heads.data() + offset[t] , int(offset[t+1] - offset[t]) , individual ? metric_K2 | metric_D | metric_D_min : metric_Omega );
+    }
+    } );
+#ifdef COUNT_ALLOCATIONS
+    //the scratch memory of the metrics comes from the arenas of the threads and the tasks of parallel_for
+    //fit in their function, so in steady state only an arena that grows or a deque of the pool that needs
+    //a new node allocates: a few times per file, whatever the number of threads
+    metric_allocations += allocation_count() - allocations_before;
+    total_trees += trees;
+#endif
+
+    //the trees of the block are added in corpus order, so the output does not depend on the threads
+    for ( std::size_t t = 0 ; t < trees ; t++ )
+    {
+      const tree_metrics &m = metrics[t];
+      if ( individual )
+      {
+        if ( binary_table != NULL )
+          binary_table->append( m , language );
+        else
+        {
+          if ( !iso_code.empty() )
+            table_writer << iso_code << ' ';
+          table_writer << m.n << ' ' << m.K2 << ' ' << m.D << ' ' << m.D_min << ' ' << '\n';
+        }
+        continue;
+      }
+      assert(-8 <= m.Omega);
+      assert(m.Omega <= 1);
+      if ( omegas && binary_output )
+        omegas_table.append( m );
+      else if ( omegas )
+        omegas_stream << m.n << ' ' << m.D << ' ' << m.D_min << ' ' << m.D_random << ' ' << m.Omega << '\n';
+      else if ( global )
+        all.insert( m.n , m.D , m.D_min , m.D_random , m.Omega );
+      else
+      {
+        if ( std::size_t(m.n) >= of_length.size() ) of_length.resize(m.n+1);
+        of_length[m.n].insert( m.n , m.D , m.D_min , m.D_random , m.Omega );
+      }
+    }
+  }
+
+#ifdef COUNT_ALLOCATIONS
+  std::cerr << heads_file_name << ": " << metric_allocations << " allocations for the metrics of " << total_trees << " trees" << endl;
+#endif
+
+  if ( global )
+    output_optimality_statistics ( all.length , all.D , all.D_min , all.D_random , all.Omega , heads_file_name , false , out );
+  else if ( by_length )
+  {
+    //same groups as compute_optimality_by_length_groups(graphs,1,false,string(heads_file_name)+string("\n"))
+    out << heads_file_name << "\n";
+    of_length.resize( std::max<std::size_t>( of_length.size() , 601 ) );
+    int minLength = 3;
+    while ( minLength < 600 )
+    {
+      int maxLength = minLength;
+      while ( of_length[maxLength].length.samples() < 1 && maxLength < 600 ) maxLength++;
+      optimality_statistics group;
+      for ( int n = minLength ; n <= maxLength ; n++ ) group.merge( of_length[n] );
+      std::size_t count = std::size_t( group.length.samples() );
+      if ( count > 0 )
+      {
+        out << minLength << " " << maxLength << " " << count << " ";
+        output_optimality_statistics ( group.length , group.D , group.D_min , group.D_random , group.Omega , "" , false , out );
+      }
+      minLength = maxLength + 1;
+    }
+  }
+  else if ( omegas && binary_output )
+  {
+    //the columns are written at the end, so they are kept in memory until then
+    if ( !write_metrics_file( omegas_file_name.c_str() , omegas_table ) )
+      std::cerr << "Problem with " << omegas_file_name << endl;
+  }
+  else if ( omegas )
+  {
+    omegas_stream.flush();
+    omegas_file.close();
+  }
 
-		assert(-8 <= Omega[i]);
-		assert(Omega[i] <= 1);
+}
+
+/**
+ * Computes the given metrics of each of the graphs in the graph vector, in parallel.
+ */
+std::vector<tree_metrics> individual_metrics ( const treebank_view &graphs , unsigned features )
+{
+	std::vector<tree_metrics> metrics( graphs.size() );
+	parallel_for ( graphs.size() , 16 , [&] ( std::size_t begin , std::size_t end ) {
+	for ( std::size_t i = begin ; i < end ; i++ ) 
+		metrics[i] = compute_tree_metrics( graphs[i] , features );
+	} );
+	return metrics;
+}
+
+/**
+ * Same as above, for trees given by their heads (no graph is built).
+ */
+std::vector<tree_metrics> individual_metrics ( const std::vector<dependency_tree> &trees , unsigned features )
+{
+	std::vector<tree_metrics> metrics( trees.size() );
+	parallel_for ( trees.size() , 16 , [&] ( std::size_t begin , std::size_t end ) {
+	for ( std::size_t i = begin ; i < end ; i++ ) 
+		metrics[i] = compute_tree_metrics( trees[i] , features );
+	} );
+	return metrics;
+}
+
+void output_individual_omegas_to_file ( const treebank_view &graphs , char * filename , std::ostream& out /*= cout*/ )
+{
+	output_individual_omegas_to_file( individual_metrics( graphs , metric_Omega ) , filename , out );
+}
+
+void output_individual_omegas_to_file ( const std::vector<tree_metrics> &metrics , char * filename , std::ostream& out /*= cout*/ )
+//with --binary, the metrics go to a binary metrics file with the name of the .omegas file followed by .bin
+{
+	for ( std::size_t i = 0 ; i < metrics.size() ; i++ ) 
+	{
+		assert(-8 <= metrics[i].Omega);
+		assert(metrics[i].Omega <= 1);
 	}
+
+	if ( binary_output )
+	{
+		std::string binary_file_name = std::string(filename) + ".bin";
+		out << "Outputting to file: " << binary_file_name << endl;
+		metrics_table table( column_n | column_D | column_D_min | column_Omega );
+		for ( std::size_t i = 0 ; i < metrics.size() ; i++ ) table.append( metrics[i] );
+		if ( !write_metrics_file( binary_file_name.c_str() , table ) )
+			std::cerr << "Problem with " << binary_file_name << endl;
+		return;
+	}
+
+	out << "Outputting to file: " << filename << endl;
 	
-	output_stream.close();
+	ofstream output_file;
+	output_file.open(filename);
+	
+	//the shortest form of each double that reads back as the same double, written in large blocks
+	buffered_writer output_stream(output_file);
+	for ( std::size_t i = 0 ; i < metrics.size() ; i++ ) 
+	{
+		const tree_metrics &m = metrics[i];
+		output_stream << m.n << ' ' << m.D << ' ' << m.D_min << ' ' << m.D_random << ' ' << m.Omega << '\n';
+	}
+	
+	output_stream.flush();
+	output_file.close();
 	
 }
 
@@ -358,23 +729,13 @@ void output_individual_omegas_to_file ( std::vector<undirected_graph> graphs , c
  * @param graphs
  * @param filename
  */
-void output_individual_antidlm_metrics_to_file ( std::vector<undirected_graph> graphs , const char * filename , const std::string& linePrefix , bool append )
+void output_individual_antidlm_metrics_to_file ( const treebank_view &graphs , const char * filename , const std::string& linePrefix , bool append , std::ostream& out /*= cout*/ )
 {
     
     static bool printed_header = false;
     
-	cout << "Outputting to file: " << filename << endl;
-	
-	std::size_t sz = graphs.size();
-
-	//vectors of metrics for each tree. Aren't really needed here (as we can just output in each iterations without storing them)
-	//but who knows.
-	std::vector<double> length = std::vector<double>(sz,0.0);
-    std::vector<double> K2 = std::vector<double>(sz,0.0);
-	std::vector<double> D = std::vector<double>(sz,0.0);
-	std::vector<double> D_min = std::vector<double>(sz,0.0);
+	out << "Outputting to file: " << filename << endl;
 	
-  
   	//this should set max precision
 	ofstream output_stream;
     if ( append )
@@ -382,56 +743,86 @@ void output_individual_antidlm_metrics_to_file ( std::vector<undirected_graph> g
     else
         output_stream.open(filename);
     
-    //apparently 17 (digits10+2) is "the minimum number of digits needed to survive a round-trip to string form and back and get the same double in the end."
-    output_stream << setprecision(numeric_limits<double>::digits10 + 2);
-  
     //this is done only in the first invocation
     if ( !printed_header )
     {
-        if ( !linePrefix.empty() )
-            output_stream << "language" << " ";
-        output_stream << "n" << " " << "K2" << " " << "D" << " " << "D_min" << " " << endl;
+        output_individual_antidlm_header( output_stream , !linePrefix.empty() );
         printed_header = true;
     }
   
-	for ( std::size_t i = 0 ; i < sz ; i++ ) 
-	{
-		undirected_graph graph = graphs[i];
+    output_individual_antidlm_metrics( graphs , output_stream , linePrefix );
+	
+	output_stream.close();
+	
+}
 
-		//process graph
-		int n = graph.vertices();
-		length[i] = double(n);
+void output_individual_antidlm_header ( std::ostream& output_stream , bool language )
+{
+    if ( language )
+        output_stream << "language" << " ";
+    output_stream << "n" << " " << "K2" << " " << "D" << " " << "D_min" << " " << endl;
+}
 
-        K2[i] = graph.sum_of_squared_degrees();
-		D[i] = graph.edge_length_sum();
-		D_min[i] = graph.minimum_edge_length_sum_of_a_tree();
+/**
+ * @brief Calculates anti-dlm related metrics of each of the graphs in the graph vector
+ * and outputs them to the stream (metrics of one graph per line), without the header.
+ * @param graphs
+ * @param output_stream
+ */
+void output_individual_antidlm_metrics ( const treebank_view &graphs , std::ostream& output_stream , const std::string& linePrefix )
+{
+	output_individual_antidlm_metrics( individual_metrics( graphs , metric_K2 | metric_D | metric_D_min ) , output_stream , linePrefix );
+}
 
+/**
+ * @brief Outputs the anti-dlm related metrics of a sequence of trees to the stream (metrics of one tree per line), without the header.
+ * @param metrics
+ * @param output_stream
+ */
+void output_individual_antidlm_metrics ( const std::vector<tree_metrics> &metrics , std::ostream& output_stream , const std::string& linePrefix )
+{
+	//the shortest form of each double that reads back as the same double, written in large blocks
+	buffered_writer writer(output_stream);
+	for ( std::size_t i = 0 ; i < metrics.size() ; i++ ) 
+	{
         if ( !linePrefix.empty() )
-            output_stream << linePrefix << " ";
-		output_stream << length[i] << " " << K2[i] << " " << D[i] << " " << D_min[i] << " "  << endl;
+            writer << linePrefix << ' ';
+		writer << metrics[i].n << ' ' << metrics[i].K2 << ' ' << metrics[i].D << ' ' << metrics[i].D_min << ' ' << '\n';
 	}
 	
-	output_stream.close();
-	
+}
+
+/**
+ * @brief Same as above, but the metrics are appended to the columns of a binary metrics table.
+ * @param metrics
+ * @param table
+ * @param language
+ */
+void output_individual_antidlm_metrics ( const std::vector<tree_metrics> &metrics , metrics_table& table , const std::string& language )
+{
+	uint16_t id = table.language_id(language);
+	for ( std::size_t i = 0 ; i < metrics.size() ; i++ ) 
+		table.append( metrics[i] , id );
 }
 
 
 /**
  * Computes metrics dividing the graphs into groups by their lengths.
  */
-void compute_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , bool c_d /*=false*/ , const std::string& linePrefix /*=""*/ )
+void compute_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , bool c_d /*=false*/ , const std::string& linePrefix /*=""*/ , std::ostream& out /*= cout*/ , std::ostream* intervals /*= NULL*/ , const std::string& language /*=""*/ , unsigned long long file_seed /*= 0*/ )
 {
+  length_index lengths(graphs);
   int minLength = 4;
   while ( minLength < 600 /*300*/ )
   {
     int maxLength = minLength;
-    std::vector< undirected_graph > current_group;
-    while ( (current_group = length_filter(graphs,minLength,maxLength)).size() < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
-    if ( !linePrefix.empty() && current_group.size() > 0 ) cout << linePrefix << " ";
+    while ( lengths.count(minLength,maxLength) < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
+    treebank_view current_group = lengths.group(minLength,maxLength);
+    if ( !linePrefix.empty() && current_group.size() > 0 ) out << linePrefix << " ";
     if ( verbose || current_group.size() > 0 )
-      cout << minLength << " " << maxLength << " " << current_group.size() << " ";
+      out << minLength << " " << maxLength << " " << current_group.size() << " ";
     if ( current_group.size() > 0 )
-      compute_detailed_metrics ( current_group , "" , verbose , c_d );
+      compute_detailed_metrics ( current_group , "" , verbose , c_d , out , intervals , language , file_seed );
     minLength = maxLength + 1;
   }
 }
@@ -439,22 +830,23 @@ void compute_by_length_groups ( std::vector< undirected_graph > graphs , std::si
 /**
  * Computes omega metrics dividing the graphs into groups by their lengths.
  */
-void compute_optimality_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/  )
+void compute_optimality_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/ , std::ostream& out /*= cout*/ )
 {
-  cout << linePrefix; //in this case, once per language (it's not really a line prefix but a language prefix, could maybe change parameter name).
+  out << linePrefix; //in this case, once per language (it's not really a line prefix but a language prefix, could maybe change parameter name).
+  length_index lengths(graphs);
   int minLength = 3;
   //while ( minLength < 300 )
   while ( minLength < 600 )
   {
     int maxLength = minLength;
-    std::vector< undirected_graph > current_group;
-    while ( (current_group = length_filter(graphs,minLength,maxLength)).size() < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
+    while ( lengths.count(minLength,maxLength) < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
+    treebank_view current_group = lengths.group(minLength,maxLength);
     //cout << linePrefix;
     //if ( !linePrefix.empty() && current_group.size() > 0 ) cout << linePrefix << " ";
     if ( verbose || current_group.size() > 0 )
-    cout << minLength << " " << maxLength << " " << current_group.size() << " ";
+    out << minLength << " " << maxLength << " " << current_group.size() << " ";
     if ( current_group.size() > 0 )
-      compute_optimality_detailed_metrics ( current_group , "" , verbose );
+      compute_optimality_detailed_metrics ( current_group , "" , verbose , out );
     minLength = maxLength + 1;
   }
 }
@@ -462,19 +854,19 @@ void compute_optimality_by_length_groups ( std::vector< undirected_graph > graph
 /**
  * Computes C, D, K2, omega metrics for "classes of grammars" paper, dividing the graphs into groups by their lengths.
  */
-void compute_grammar_optimality_by_lengths ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/  )
+void compute_grammar_optimality_by_lengths ( const treebank_view &graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/ , std::ostream& out /*= cout*/ )
 {
+  length_index lengths(graphs);
   for ( int length = 2 ; length < 30 ; length++ )  //this analysis is done on artificial trees of quite limited length
   {
-    std::vector< undirected_graph > current_group;
     //cout << "len " << length << "\n";
-    current_group = length_filter(graphs,length,length);
+    treebank_view current_group = lengths.group(length,length);
     if  ( current_group.size() >= minAmountPerGroup )
     {
-        cout << length << " ";
-        if ( !linePrefix.empty() ) cout << linePrefix << " ";
-        cout << current_group.size() << " ";
-        compute_grammar_optimality_detailed_metrics ( current_group , "" , verbose );
+        out << length << " ";
+        if ( !linePrefix.empty() ) out << linePrefix << " ";
+        out << current_group.size() << " ";
+        compute_grammar_optimality_detailed_metrics ( current_group , "" , verbose , out );
     }
   }
 }
@@ -482,25 +874,26 @@ void compute_grammar_optimality_by_lengths ( std::vector< undirected_graph > gra
 /**
  * Computes antiDLM metrics dividing the graphs into groups by their lengths.
  */
-void compute_antidlm_by_length_groups ( std::vector< undirected_graph > graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/ )
+void compute_antidlm_by_length_groups ( const treebank_view &graphs , std::size_t minAmountPerGroup  , bool verbose /*= true*/ , const std::string& linePrefix /*=""*/ , std::ostream& out /*= cout*/ )
 {
+  length_index lengths(graphs);
   int minLength = 3;
   //while ( minLength < 300 )
   while ( minLength < 600 )
   {
     int maxLength = minLength;
-    std::vector< undirected_graph > current_group;
-    while ( (current_group = length_filter(graphs,minLength,maxLength)).size() < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
-    if ( !linePrefix.empty() && current_group.size() > 0 ) cout << linePrefix << " ";
+    while ( lengths.count(minLength,maxLength) < minAmountPerGroup && maxLength < 600 /*300*/ ) maxLength++;
+    treebank_view current_group = lengths.group(minLength,maxLength);
+    if ( !linePrefix.empty() && current_group.size() > 0 ) out << linePrefix << " ";
     if ( verbose || current_group.size() > 0 )
-    cout << minLength << " " << maxLength << " " << current_group.size() << " ";
+    out << minLength << " " << maxLength << " " << current_group.size() << " ";
     if ( current_group.size() > 0 )
-      compute_antidlm_detailed_metrics ( current_group , "" , verbose );
+      compute_antidlm_detailed_metrics ( current_group , "" , verbose , out );
     minLength = maxLength + 1;
   }
 }
 
-void compute_metrics ( std::vector<undirected_graph> graphs )
+void compute_metrics ( const treebank_view &graphs , std::ostream& out /*= cout*/ )
 {
 
   /*
@@ -537,12 +930,13 @@ void compute_metrics ( std::vector<undirected_graph> graphs )
   for ( std::size_t i = 0 ; i < graphs.size() ; i++ ) 
   {
 
-    undirected_graph graph = graphs[i];
+    const undirected_graph &graph = graphs[i];
 
     //process graph: current_graph
-    int n = graph.vertices();
-    probability_of_crossing_knowing_edge_lengths p(n);
-    double degree_2nd_moment = graph.degree_2nd_moment();
+    tree_metrics m = compute_tree_metrics( graph , metric_K2 | metric_C );
+    int n = m.n;
+    const probability_of_crossing_knowing_edge_lengths &p = probability_of_crossing_table(n);
+    double degree_2nd_moment = m.K2/double(n);
     int potential_crossings;
     double expected_crossings2;
 
@@ -550,8 +944,8 @@ void compute_metrics ( std::vector<undirected_graph> graphs )
     assert(0 <= crossings_max);
     assert(crossings_max <= (n-1)*(n-2)/2);
     double expected_crossings0 = n*(n - 1 - degree_2nd_moment)/double(6);
-    expected_crossings2 = graph.fully_predicted_crossings(p, potential_crossings);
-    int crossings = graph.crossings();
+    expected_crossings2 = graph.fully_predicted_crossings_by_length(p, potential_crossings);
+    int crossings = m.C;
     //cout << "Tree number: " << (i+1) << endl;
 
     double rel_crossings = crossings/crossings_max;
@@ -614,7 +1008,7 @@ void compute_metrics ( std::vector<undirected_graph> graphs )
      */
   }
 
-  cout << "Average metrics:" << endl;
+  out << "Average metrics:" << endl;
 
 
   /*
@@ -632,21 +1026,21 @@ void compute_metrics ( std::vector<undirected_graph> graphs )
   double avg_abs_delta2 = sum_abs_delta2 / d_num_graphs;
   */
 
-  cout << setprecision(5);
-  cout << "   Number of vertices ($n$): " << avg_n << endl;
-  cout << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << avg_degree_2nd_moment << endl;
-  cout << "   Maximum number of crossings ($C_{max}$): " << avg_crossings_max << endl;
-  cout << "   Crossings ($C_{true}$): " << avg_crossings << endl;
-  cout << "   Predicted crossings0 ($E_0[C]$): " << avg_expected_crossings0 << endl;
-  cout << "   Predicted crossings2 ($E_2[C]$): " << avg_expected_crossings2 << endl;
-  cout << "   Relative crossings ($\\bar{C}_{true}$): " << avg_rel_crossings << endl;
-  cout << "   Predicted relative crossings0 ($E_0[\\bar{C}]$): " << avg_predicted_rel_crossings0 << endl;
-  cout << "   Predicted relative crossings2 ($E_2[\\bar{C}]$): " << avg_predicted_rel_crossings2 << endl;
+  out << setprecision(5);
+  out << "   Number of vertices ($n$): " << avg_n << endl;
+  out << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << avg_degree_2nd_moment << endl;
+  out << "   Maximum number of crossings ($C_{max}$): " << avg_crossings_max << endl;
+  out << "   Crossings ($C_{true}$): " << avg_crossings << endl;
+  out << "   Predicted crossings0 ($E_0[C]$): " << avg_expected_crossings0 << endl;
+  out << "   Predicted crossings2 ($E_2[C]$): " << avg_expected_crossings2 << endl;
+  out << "   Relative crossings ($\\bar{C}_{true}$): " << avg_rel_crossings << endl;
+  out << "   Predicted relative crossings0 ($E_0[\\bar{C}]$): " << avg_predicted_rel_crossings0 << endl;
+  out << "   Predicted relative crossings2 ($E_2[\\bar{C}]$): " << avg_predicted_rel_crossings2 << endl;
   // Information for Fig. 4 (applying Eq. 25)
-  cout << "   Abs. Relative error of prediction0 ($\\Delta_0$): " << avg_abs_delta0 << endl;
-  cout << "   Abs. Relative error of prediction2 ($\\Delta_2$): " << avg_abs_delta2 << endl;
-  cout << "   Relative error of prediction0 ($\\Delta_0$): " << avg_delta0 << endl;
-  cout << "   Relative error of prediction2 ($\\Delta_2$): " << avg_delta2 << endl;
+  out << "   Abs. Relative error of prediction0 ($\\Delta_0$): " << avg_abs_delta0 << endl;
+  out << "   Abs. Relative error of prediction2 ($\\Delta_2$): " << avg_abs_delta2 << endl;
+  out << "   Relative error of prediction0 ($\\Delta_0$): " << avg_delta0 << endl;
+  out << "   Relative error of prediction2 ($\\Delta_2$): " << avg_delta2 << endl;
 
 }
 
@@ -654,7 +1048,7 @@ void calculate(const string &label, const undirected_graph &g)
 {
   assert(g.tree());
   int n = g.vertices();
-  probability_of_crossing_knowing_edge_lengths p(n);
+  const probability_of_crossing_knowing_edge_lengths &p = probability_of_crossing_table(n);
   double degree_2nd_moment = g.degree_2nd_moment();
   int potential_crossings;
   double expected_crossings2;
@@ -683,107 +1077,78 @@ void calculate(const string &label, const undirected_graph &g)
 }
 
 
-double overflow_safe_average ( std::vector<double> myvector )
-{
-  double avg = 0.0;
-  std::size_t sz = myvector.size();
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
-  {
-    avg += myvector[i] / sz;
-  }
-  return avg;
-}
-
-double overflow_safe_stdev ( std::vector<double> myvector )
-{
-  double avg = overflow_safe_average(myvector);
-  double variance = 0.0;
-  std::size_t sz = myvector.size();
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
-  {
-    variance += ( ((myvector[i]-avg)*(myvector[i]-avg)) / sz );
-  }
-  return sqrt(variance);
-}
-
-double median ( std::vector<double> myvector )
-{
-  double median;
-  std::size_t sz = myvector.size();
-  sort(myvector.begin(), myvector.end());
-  if (sz  % 2 == 0) 
-  {
-    median = (myvector[sz/2-1] + myvector[sz/2]) / 2.0;
-  } else 
-  {
-    median = myvector[sz/2];
-  }
-  return median;
-}
-
-std::vector<undirected_graph> length_filter ( std::vector<undirected_graph> input , int min_length , int max_length )
+treebank_view length_filter ( const treebank_view &input , int min_length , int max_length )
 {
-	std::vector<undirected_graph> result;
+	std::vector<int> result;
 	std::size_t sz = input.size();
 	for ( std::size_t i = 0 ; i < sz ; i++ )
 	{
-		undirected_graph g = input[i];
-		int len = g.vertices();
+		int len = input[i].vertices();
 		if ( len >= min_length && len <= max_length )
-			result.push_back(g);
+			result.push_back(input.position(i));
 	} 
-	return result;
+	return treebank_view(input.treebank(),result);
 }
 
 /**
  * Includes standard deviation, etc.
  */
-void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix , bool verbose /*= true*/ , bool c_d /*=false*/ )
+void compute_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix , bool verbose /*= true*/ , bool c_d /*=false*/ , std::ostream& out /*= cout*/ , std::ostream* intervals /*= NULL*/ , const std::string& language /*=""*/ , unsigned long long file_seed /*= 0*/ )
 {
 
   std::size_t sz = graphs.size();
 
 
-  //vectors of metrics for each tree:
-  std::vector<double> length = std::vector<double>(sz,0.0);
-  std::vector<double> degree_2nd_moment = std::vector<double>(sz,0.0);
-  std::vector<double> crossings_max = std::vector<double>(sz,0.0);
-  std::vector<double> crossings = std::vector<double>(sz,0.0);
-  std::vector<double> expected_crossings0 = std::vector<double>(sz,0.0);
-  std::vector<double> expected_crossings2 = std::vector<double>(sz,0.0);
-  std::vector<double> expected_crossingsD = std::vector<double>(sz,0.0);
-  std::vector<double> rel_crossings = std::vector<double>(sz,0.0);
-  std::vector<double> predicted_rel_crossings0 = std::vector<double>(sz,0.0);
-  std::vector<double> predicted_rel_crossings2 = std::vector<double>(sz,0.0);
-  std::vector<double> predicted_rel_crossingsD = std::vector<double>(sz,0.0);
-  std::vector<double> abs_delta0 = std::vector<double>(sz,0.0);
-  std::vector<double> abs_delta2 = std::vector<double>(sz,0.0);
-   std::vector<double> abs_deltaD = std::vector<double>(sz,0.0);
-  std::vector<double> delta0 = std::vector<double>(sz,0.0);
-  std::vector<double> delta2 = std::vector<double>(sz,0.0);
-  std::vector<double> deltaD = std::vector<double>(sz,0.0);
+  std::size_t block = std::min( sz , trees_per_block );
+  //statistics of each metric over all trees, computed a block of trees at a time:
+  block_statistics length(block);
+  block_statistics degree_2nd_moment(block);
+  block_statistics crossings_max(block);
+  block_statistics crossings(block);
+  block_statistics expected_crossings0(block);
+  block_statistics expected_crossings2(block);
+  running_statistics expected_crossingsD; //this and the other metrics of E[C|D] are inserted after every block, for the trees with an estimate
+  block_statistics rel_crossings(block);
+  block_statistics predicted_rel_crossings0(block);
+  block_statistics predicted_rel_crossings2(block);
+  running_statistics predicted_rel_crossingsD;
+  block_statistics abs_delta0(block);
+  block_statistics abs_delta2(block);
+  running_statistics abs_deltaD;
+  block_statistics delta0(block);
+  block_statistics delta2(block);
+  running_statistics deltaD;
+  std::vector<crossings_estimate> estimatesD( c_d ? block : 0 ); //of E[C|D] in the current block
+  double half_widthD = 0; //sum of the half widths of the confidence intervals of the sampled E[C|D]
+  std::size_t sampledD = 0;
+  std::size_t skippedD = 0; //trees whose chain never reached their sum of lengths, so they have no E[C|D]
   
   //even more vectors of metrics (for small.tex, 2016-11-14):
-  std::vector<double> crossings_max_linear = std::vector<double>(sz,0.0); //Q_linear
-  std::vector<double> expected_crossings_urlt = std::vector<double>(sz,0.0); //E_URLT(Q/3)
-  std::vector<double> crossings_ratio_to_qlinear = std::vector<double>(sz,0.0); //Ctrue/Qlinear
-  std::vector<double> crossings_ratio_to_exp_urlt = std::vector<double>(sz,0.0); //Ctrue/Eurlt
-  std::vector<double> crossings_ratio_to_exp_urla = std::vector<double>(sz,0.0); //Ctrue/Eurla = Ctrue/expected_crossings_0
-  std::vector<double> is_planar = std::vector<double>(sz,0.0); //1.0 if crossings == 0, 0.0 otherwise
-  std::vector<double> hubiness = std::vector<double>(sz,0.0); //hubiness coefficient h
-  std::vector<double> exp_urlt_hubiness = std::vector<double>(sz,0.0); //expected hubiness coefficient for a random linear tree of this size, eq. 1/n
-  std::vector<double> crossings_ratio_to_exp_urlt_minus_star = std::vector<double>(sz,0.0); //Ctrue/Eurlt(Q/3 not star)
-  std::vector<double> expected_crossings_urlt_minus_star = std::vector<double>(sz,0.0); //E_URLT(Q/3 not star)
-  std::vector<double> exp_urlt_hubiness_minus_star = std::vector<double>(sz,0.0); //expected hubiness coefficient for u.r.l.t. excluding star trees
+  block_statistics crossings_max_linear(block); //Q_linear
+  block_statistics expected_crossings_urlt(block); //E_URLT(Q/3)
+  block_statistics crossings_ratio_to_qlinear(block); //Ctrue/Qlinear
+  block_statistics crossings_ratio_to_exp_urlt(block); //Ctrue/Eurlt
+  block_statistics crossings_ratio_to_exp_urla(block); //Ctrue/Eurla = Ctrue/expected_crossings_0
+  block_statistics is_planar(block); //1.0 if crossings == 0, 0.0 otherwise
+  block_statistics hubiness(block); //hubiness coefficient h
+  block_statistics exp_urlt_hubiness(block); //expected hubiness coefficient for a random linear tree of this size, eq. 1/n
+  block_statistics crossings_ratio_to_exp_urlt_minus_star(block); //Ctrue/Eurlt(Q/3 not star)
+  block_statistics expected_crossings_urlt_minus_star(block); //E_URLT(Q/3 not star)
+  block_statistics exp_urlt_hubiness_minus_star(block); //expected hubiness coefficient for u.r.l.t. excluding star trees
   
   
   //std::ofstream fout;
   //fout.open("log.txt");
 
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
+  std::vector<block_statistics*> metrics = { &length , &degree_2nd_moment , &crossings_max , &crossings , &expected_crossings0 , &expected_crossings2 , &rel_crossings , &predicted_rel_crossings0 , &predicted_rel_crossings2 , &abs_delta0 , &abs_delta2 , &delta0 , &delta2 , &crossings_max_linear , &expected_crossings_urlt , &crossings_ratio_to_qlinear , &crossings_ratio_to_exp_urlt , &crossings_ratio_to_exp_urla , &is_planar , &hubiness , &exp_urlt_hubiness , &crossings_ratio_to_exp_urlt_minus_star , &expected_crossings_urlt_minus_star , &exp_urlt_hubiness_minus_star };
+  for ( std::size_t first = 0 ; first < sz ; first += block )
+  {
+  std::size_t last = std::min( sz , first + block );
+  parallel_for ( last - first , 16 , [&] ( std::size_t begin , std::size_t end ) {
+  for ( std::size_t i = first + begin ; i < first + end ; i++ ) 
   {
 
-    undirected_graph graph = graphs[i];
+    const undirected_graph &graph = graphs[i];
     
     //if ( i % 100 == 0 ) cout << i << endl;
 	//write_graph_on_ofstream ( graph , fout );
@@ -791,32 +1156,35 @@ void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std
 	//cout << "Tree " << i << " size " << graph.vertices() << endl;
 
     //process graph: current_graph
-    int n = graph.vertices();
+    tree_metrics m = compute_tree_metrics( graph , metric_K2 | metric_C );
+    int n = m.n;
     length[i] = double(n);
 
-    probability_of_crossing_knowing_edge_lengths p(n);
-    degree_2nd_moment[i] = graph.degree_2nd_moment();
+    const probability_of_crossing_knowing_edge_lengths &p = probability_of_crossing_table(n);
+    degree_2nd_moment[i] = m.K2/double(n);
     int potential_crossings;
 
     crossings_max[i] = n*(n - 1 - degree_2nd_moment[i])/double(2); //a.k.a. |Q| in small.tex
     assert(0 <= crossings_max[i]);
     assert(crossings_max[i] <= (n-1)*(n-2)/2);
     expected_crossings0[i] = n*(n - 1 - degree_2nd_moment[i])/double(6);
-    expected_crossings2[i] = graph.fully_predicted_crossings(p, potential_crossings);
-	if ( c_d ) expected_crossingsD[i] = crossings_at_constant_sum_of_lengths(graph);
-    crossings[i] = double(graph.crossings());
+    expected_crossings2[i] = graph.fully_predicted_crossings_by_length(p, potential_crossings);
+	if ( c_d )
+	{
+		std::seed_seq seeds{ c_d_seed & 0xffffffffULL , c_d_seed >> 32 , file_seed & 0xffffffffULL , file_seed >> 32 , (unsigned long long)(graphs.position(i)) };
+		std::mt19937_64 random( seeds );
+		estimatesD[i - first] = expected_crossings_at_constant_sum_of_lengths( graph , c_d_exact_vertices , c_d_sampling , random );
+	}
+    crossings[i] = double(m.C);
     //cout << "Tree number: " << (i+1) << endl;
 
     rel_crossings[i] = crossings[i]/crossings_max[i]; //a.k.a. C_true/|Q| in small.tex
     predicted_rel_crossings0[i] = expected_crossings0[i]/crossings_max[i];
     predicted_rel_crossings2[i] = expected_crossings2[i]/crossings_max[i];
-	if ( c_d ) predicted_rel_crossingsD[i] = expected_crossingsD[i]/crossings_max[i];
     abs_delta0[i] = abs((expected_crossings0[i] - crossings[i])/crossings_max[i]);
     abs_delta2[i] = abs((expected_crossings2[i] - crossings[i])/crossings_max[i]);
-	if ( c_d ) abs_deltaD[i] = abs((expected_crossingsD[i] - crossings[i])/crossings_max[i]);
     delta0[i] = (expected_crossings0[i] - crossings[i])/crossings_max[i];
     delta2[i] = (expected_crossings2[i] - crossings[i])/crossings_max[i];
-	if ( c_d ) deltaD[i] = (expected_crossingsD[i] - crossings[i])/crossings_max[i];
 
     //even more vectors of metrics (for small.tex, 2016-11-14):
     crossings_max_linear[i] = double((n-2)*(n-3))/double(2);
@@ -824,7 +1192,7 @@ void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std
     crossings_ratio_to_qlinear[i] = crossings[i] / crossings_max_linear[i];
     crossings_ratio_to_exp_urlt[i] = crossings[i] / expected_crossings_urlt[i];
     crossings_ratio_to_exp_urla[i] = crossings[i] / expected_crossings0[i];
-    is_planar[i] = (graph.crossings()==0)?1.0:0.0;
+    is_planar[i] = (m.C==0)?1.0:0.0;
     hubiness[i] = (double(n) * (degree_2nd_moment[i]-4.0) + 6.0) / double((n-2)*(n-3));
     exp_urlt_hubiness[i] = (double(1.0) / double(n));
 	expected_crossings_urlt_minus_star[i] = double((n-1)*(n-2)*(n-3))/double(6.0*(n-pow(n,4.0-n)));
@@ -835,82 +1203,111 @@ void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std
 		exp_urlt_hubiness_minus_star[i] = ( (pow(n,n) - pow(n,4.0) ) /  (pow(n,n+1) - pow(n,4.0)  ) ); //use the formula
 
   }
+  } );
+  if ( c_d )
+  {
+    for ( std::size_t i = first ; i < last ; i++ )
+    {
+      const crossings_estimate &e = estimatesD[i - first];
+      if ( !e.exact && e.samples == 0 ) //NaN, which would spoil the statistics of the whole group
+        skippedD++;
+      else
+      {
+        expected_crossingsD.insert( e.mean );
+        predicted_rel_crossingsD.insert( e.mean/crossings_max[i] );
+        abs_deltaD.insert( abs((e.mean - crossings[i])/crossings_max[i]) );
+        deltaD.insert( (e.mean - crossings[i])/crossings_max[i] );
+      }
+      if ( !e.exact && e.samples > 0 )
+      {
+        half_widthD += (e.upper - e.lower)/2;
+        sampledD++;
+      }
+      if ( intervals != NULL ) *intervals << language << " " << length[i] << " " << graphs[i].edge_length_sum() << " " << crossings[i] << " " << e.mean << " " << e.lower << " " << e.upper << " " << e.samples << endl;
+    }
+  }
+  for ( std::size_t m = 0 ; m < metrics.size() ; m++ ) metrics[m]->flush( last - first );
+  }
+  if ( skippedD > 0 )
+    std::cerr << ( linePrefix.empty() ? language : linePrefix ) << ": " << skippedD << " of " << sz << " trees left out of E[C|D], their chains never reached their sum of lengths" << endl;
   
 
-  cout << setprecision(5);
+  out << setprecision(5);
 
   if ( verbose ) 
   {
 
-		if ( !linePrefix.empty() ) cout << linePrefix << endl;
-    cout << "   Number of vertices ($n$): " << overflow_safe_average(length) << endl;
-    cout << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << overflow_safe_average(degree_2nd_moment) << endl;
-    cout << "   Maximum number of crossings ($C_{max}$): " << overflow_safe_average(crossings_max) << endl;
-    cout << "   Crossings ($C_{true}$): " << overflow_safe_average(crossings) << endl;
-    cout << "   Predicted crossings0 ($E_0[C]$): " << overflow_safe_average(expected_crossings0) << endl;
-    cout << "   Predicted crossings2 ($E_2[C]$): " << overflow_safe_average(expected_crossings2) << endl;
-	if ( c_d ) cout << "   Predicted crossings at constant D ($E[C|D]$): " << overflow_safe_average(expected_crossingsD) << endl; 
-    cout << "   Relative crossings ($\\bar{C}_{true}$): " << overflow_safe_average(rel_crossings) << endl;
-    cout << "   Predicted relative crossings0 ($E_0[\\bar{C}]$): " << overflow_safe_average(predicted_rel_crossings0) << endl;
-    cout << "   Predicted relative crossings2 ($E_2[\\bar{C}]$): " << overflow_safe_average(predicted_rel_crossings2) << endl;
-	if ( c_d ) cout << "   Predicted relative crossings at constant D ($E[\\bar{C}| D]$): " << overflow_safe_average(predicted_rel_crossingsD) << endl;
+		if ( !linePrefix.empty() ) out << linePrefix << endl;
+    out << "   Number of vertices ($n$): " << length.mean() << endl;
+    out << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << degree_2nd_moment.mean() << endl;
+    out << "   Maximum number of crossings ($C_{max}$): " << crossings_max.mean() << endl;
+    out << "   Crossings ($C_{true}$): " << crossings.mean() << endl;
+    out << "   Predicted crossings0 ($E_0[C]$): " << expected_crossings0.mean() << endl;
+    out << "   Predicted crossings2 ($E_2[C]$): " << expected_crossings2.mean() << endl;
+	if ( c_d ) out << "   Predicted crossings at constant D ($E[C|D]$): " << expected_crossingsD.mean() << endl; 
+	if ( c_d && skippedD > 0 ) out << "   Trees without $E[C|D]$ (left out): " << skippedD << endl;
+	if ( c_d && sampledD > 0 ) out << "   Trees with sampled $E[C|D]$: " << sampledD << ", mean half width of the 95% confidence intervals: " << half_widthD/sampledD << endl;
+    out << "   Relative crossings ($\\bar{C}_{true}$): " << rel_crossings.mean() << endl;
+    out << "   Predicted relative crossings0 ($E_0[\\bar{C}]$): " << predicted_rel_crossings0.mean() << endl;
+    out << "   Predicted relative crossings2 ($E_2[\\bar{C}]$): " << predicted_rel_crossings2.mean() << endl;
+	if ( c_d ) out << "   Predicted relative crossings at constant D ($E[\\bar{C}| D]$): " << predicted_rel_crossingsD.mean() << endl;
     // Information for Fig. 4 (applying Eq. 25)
-    cout << "   Abs. Relative error of prediction0 ($\\Delta_0$): " << overflow_safe_average(abs_delta0) << endl;
-    cout << "   Abs. Relative error of prediction2 ($\\Delta_2$): " << overflow_safe_average(abs_delta2) << endl;
-	if ( c_d ) cout << "   Abs. Relative error of expected crossings at constant D ($?$): " << overflow_safe_average(abs_deltaD) << endl;
-    cout << "   Relative error of prediction0 ($\\Delta_0$): " << overflow_safe_average(delta0) << endl;
-    cout << "   Relative error of prediction2 ($\\Delta_2$): " << overflow_safe_average(delta2) << endl;
-	if ( c_d ) cout << "   Relative error of expected crossings at constant D ($?$): " << overflow_safe_average(deltaD) << endl;
+    out << "   Abs. Relative error of prediction0 ($\\Delta_0$): " << abs_delta0.mean() << endl;
+    out << "   Abs. Relative error of prediction2 ($\\Delta_2$): " << abs_delta2.mean() << endl;
+	if ( c_d ) out << "   Abs. Relative error of expected crossings at constant D ($?$): " << abs_deltaD.mean() << endl;
+    out << "   Relative error of prediction0 ($\\Delta_0$): " << delta0.mean() << endl;
+    out << "   Relative error of prediction2 ($\\Delta_2$): " << delta2.mean() << endl;
+	if ( c_d ) out << "   Relative error of expected crossings at constant D ($?$): " << deltaD.mean() << endl;
 
     //even more vectors of metrics (for small.tex, 2016-11-14):
-    cout << "   Max crossings of linear tree of this length ($Q_{linear}$): " << overflow_safe_average(crossings_max_linear) << endl;
-    cout << "   Expected crossings for uniformly random labelled tree ($E_{URLT}[|Q|/3]$): " << overflow_safe_average(expected_crossings_urlt) << endl;
-    cout << "   Crossings ratio to Qlinear: " << overflow_safe_average(crossings_ratio_to_qlinear) << endl;
-    cout << "   Crossings ratio to expected for u.r.l.t.: " << overflow_safe_average(crossings_ratio_to_exp_urlt) << endl;
-    cout << "   Crossings ratio to expected for u.r.l.a.: " << overflow_safe_average(crossings_ratio_to_exp_urla) << endl;
-    cout << "   Planarity: " << overflow_safe_average(is_planar) << endl;
-    cout << "   Hubiness: " << overflow_safe_average(hubiness) << endl;
-    cout << "   Expected hubiness for u.r.l.t.: " << overflow_safe_average(exp_urlt_hubiness) << endl;
-	cout << "   Expected crossings for uniformly random labelled tree ($E_{URLT}[|Q|/3]$) corrected for star trees: " << overflow_safe_average(expected_crossings_urlt_minus_star) << endl;
-	cout << "   Crossings ratio to expected for u.r.l.t. corrected for star trees: " << overflow_safe_average(crossings_ratio_to_exp_urlt_minus_star) << endl;
-	cout << "   Expected hubiness for u.r.l.t. corrected for star trees: " << overflow_safe_average(exp_urlt_hubiness_minus_star) << endl;
-
-    cout << "CSV format metrics for table:" << endl;
+    out << "   Max crossings of linear tree of this length ($Q_{linear}$): " << crossings_max_linear.mean() << endl;
+    out << "   Expected crossings for uniformly random labelled tree ($E_{URLT}[|Q|/3]$): " << expected_crossings_urlt.mean() << endl;
+    out << "   Crossings ratio to Qlinear: " << crossings_ratio_to_qlinear.mean() << endl;
+    out << "   Crossings ratio to expected for u.r.l.t.: " << crossings_ratio_to_exp_urlt.mean() << endl;
+    out << "   Crossings ratio to expected for u.r.l.a.: " << crossings_ratio_to_exp_urla.mean() << endl;
+    out << "   Planarity: " << is_planar.mean() << endl;
+    out << "   Hubiness: " << hubiness.mean() << endl;
+    out << "   Expected hubiness for u.r.l.t.: " << exp_urlt_hubiness.mean() << endl;
+	out << "   Expected crossings for uniformly random labelled tree ($E_{URLT}[|Q|/3]$) corrected for star trees: " << expected_crossings_urlt_minus_star.mean() << endl;
+	out << "   Crossings ratio to expected for u.r.l.t. corrected for star trees: " << crossings_ratio_to_exp_urlt_minus_star.mean() << endl;
+	out << "   Expected hubiness for u.r.l.t. corrected for star trees: " << exp_urlt_hubiness_minus_star.mean() << endl;
+
+    out << "CSV format metrics for table:" << endl;
 
   }
 
-	if ( !linePrefix.empty() ) cout << linePrefix << " ";
-  cout << overflow_safe_average(length) << " " << median(length) << " " << overflow_safe_stdev(length) << " ";
+	if ( !linePrefix.empty() ) out << linePrefix << " ";
+  out << length.mean() << " " << length.median() << " " << length.stdev() << " ";
   //metrics[0]-metrics[32]
-  cout << overflow_safe_average(crossings) << " " << median(crossings) << " " << overflow_safe_stdev(crossings) << " ";
-  cout << overflow_safe_average(crossings_max) << " " << median(crossings_max) << " " << overflow_safe_stdev(crossings_max) << " ";
-  cout << overflow_safe_average(expected_crossings0) << " " << median(expected_crossings0) << " " << overflow_safe_stdev(expected_crossings0) << " ";
-  cout << overflow_safe_average(expected_crossings2) << " " << median(expected_crossings2) << " " << overflow_safe_stdev(expected_crossings2) << " ";
-  if ( c_d ) cout << overflow_safe_average(expected_crossingsD) << " " << median(expected_crossingsD) << " " << overflow_safe_stdev(expected_crossingsD) << " ";
-  cout << overflow_safe_average(rel_crossings) << " " << median(rel_crossings) << " " << overflow_safe_stdev(rel_crossings) << " ";
-  cout << overflow_safe_average(predicted_rel_crossings0) << " " << median(predicted_rel_crossings0) << " " << overflow_safe_stdev(predicted_rel_crossings0) << " ";
-  cout << overflow_safe_average(predicted_rel_crossings2) << " " << median(predicted_rel_crossings2) << " " << overflow_safe_stdev(predicted_rel_crossings2) << " ";
-  if ( c_d ) cout << overflow_safe_average(predicted_rel_crossingsD) << " " << median(predicted_rel_crossingsD) << " " << overflow_safe_stdev(predicted_rel_crossingsD) << " ";
-  cout << overflow_safe_average(abs_delta0) << " " << median(abs_delta0) << " " << overflow_safe_stdev(abs_delta0) << " ";
-  cout << overflow_safe_average(abs_delta2) << " " << median(abs_delta2) << " " << overflow_safe_stdev(abs_delta2) << " ";
-  if ( c_d ) cout << overflow_safe_average(abs_deltaD) << " " << median(abs_deltaD) << " " << overflow_safe_stdev(abs_deltaD) << " ";
-  cout << overflow_safe_average(delta0) << " " << median(delta0) << " " << overflow_safe_stdev(delta0) << " ";
-  cout << overflow_safe_average(delta2) << " " << median(delta2) << " " << overflow_safe_stdev(delta2) << " ";
-  if ( c_d ) cout << overflow_safe_average(deltaD) << " " << median(deltaD) << " " << overflow_safe_stdev(deltaD) << " ";
+  out << crossings.mean() << " " << crossings.median() << " " << crossings.stdev() << " ";
+  out << crossings_max.mean() << " " << crossings_max.median() << " " << crossings_max.stdev() << " ";
+  out << expected_crossings0.mean() << " " << expected_crossings0.median() << " " << expected_crossings0.stdev() << " ";
+  out << expected_crossings2.mean() << " " << expected_crossings2.median() << " " << expected_crossings2.stdev() << " ";
+  if ( c_d ) out << expected_crossingsD.mean() << " " << expected_crossingsD.median() << " " << expected_crossingsD.stdev() << " ";
+  out << rel_crossings.mean() << " " << rel_crossings.median() << " " << rel_crossings.stdev() << " ";
+  out << predicted_rel_crossings0.mean() << " " << predicted_rel_crossings0.median() << " " << predicted_rel_crossings0.stdev() << " ";
+  out << predicted_rel_crossings2.mean() << " " << predicted_rel_crossings2.median() << " " << predicted_rel_crossings2.stdev() << " ";
+  if ( c_d ) out << predicted_rel_crossingsD.mean() << " " << predicted_rel_crossingsD.median() << " " << predicted_rel_crossingsD.stdev() << " ";
+  out << abs_delta0.mean() << " " << abs_delta0.median() << " " << abs_delta0.stdev() << " ";
+  out << abs_delta2.mean() << " " << abs_delta2.median() << " " << abs_delta2.stdev() << " ";
+  if ( c_d ) out << abs_deltaD.mean() << " " << abs_deltaD.median() << " " << abs_deltaD.stdev() << " ";
+  out << delta0.mean() << " " << delta0.median() << " " << delta0.stdev() << " ";
+  out << delta2.mean() << " " << delta2.median() << " " << delta2.stdev() << " ";
+  if ( c_d ) out << deltaD.mean() << " " << deltaD.median() << " " << deltaD.stdev() << " ";
   //even more vectors of metrics (for small.tex, 2016-11-14). metrics[33]-metrics[59] in length group entries in the Java code:
-  cout << overflow_safe_average(crossings_max_linear) << " " << median(crossings_max_linear) << " " << overflow_safe_stdev(crossings_max_linear) << " ";
-  cout << overflow_safe_average(expected_crossings_urlt) << " " << median(expected_crossings_urlt) << " " << overflow_safe_stdev(expected_crossings_urlt) << " ";
-  cout << overflow_safe_average(crossings_ratio_to_qlinear) << " " << median(crossings_ratio_to_qlinear) << " " << overflow_safe_stdev(crossings_ratio_to_qlinear) << " ";
-  cout << overflow_safe_average(crossings_ratio_to_exp_urlt) << " " << median(crossings_ratio_to_exp_urlt) << " " << overflow_safe_stdev(crossings_ratio_to_exp_urlt) << " ";
-  cout << overflow_safe_average(crossings_ratio_to_exp_urla) << " " << median(crossings_ratio_to_exp_urla) << " " << overflow_safe_stdev(crossings_ratio_to_exp_urla) << " ";
-  cout << overflow_safe_average(is_planar) << " " << median(is_planar) << " " << overflow_safe_stdev(is_planar) << " ";
-  cout << overflow_safe_average(degree_2nd_moment) << " " << median(degree_2nd_moment) << " " << overflow_safe_stdev(degree_2nd_moment) << " ";
-  cout << overflow_safe_average(hubiness) << " " << median(hubiness) << " " << overflow_safe_stdev(hubiness) << " ";
-  cout << overflow_safe_average(exp_urlt_hubiness) << " " << median(exp_urlt_hubiness) << " " << overflow_safe_stdev(exp_urlt_hubiness) << " ";
-  cout << overflow_safe_average(expected_crossings_urlt_minus_star) << " " << median(expected_crossings_urlt_minus_star) << " " << overflow_safe_stdev(expected_crossings_urlt_minus_star) << " ";
-  cout << overflow_safe_average(crossings_ratio_to_exp_urlt_minus_star) << " " << median(crossings_ratio_to_exp_urlt_minus_star) << " " << overflow_safe_stdev(crossings_ratio_to_exp_urlt_minus_star) << " ";
-  cout << overflow_safe_average(exp_urlt_hubiness_minus_star) << " " << median(exp_urlt_hubiness_minus_star) << " " << overflow_safe_stdev(exp_urlt_hubiness_minus_star) << " ";
-  cout << endl;
+  out << crossings_max_linear.mean() << " " << crossings_max_linear.median() << " " << crossings_max_linear.stdev() << " ";
+  out << expected_crossings_urlt.mean() << " " << expected_crossings_urlt.median() << " " << expected_crossings_urlt.stdev() << " ";
+  out << crossings_ratio_to_qlinear.mean() << " " << crossings_ratio_to_qlinear.median() << " " << crossings_ratio_to_qlinear.stdev() << " ";
+  out << crossings_ratio_to_exp_urlt.mean() << " " << crossings_ratio_to_exp_urlt.median() << " " << crossings_ratio_to_exp_urlt.stdev() << " ";
+  out << crossings_ratio_to_exp_urla.mean() << " " << crossings_ratio_to_exp_urla.median() << " " << crossings_ratio_to_exp_urla.stdev() << " ";
+  out << is_planar.mean() << " " << is_planar.median() << " " << is_planar.stdev() << " ";
+  out << degree_2nd_moment.mean() << " " << degree_2nd_moment.median() << " " << degree_2nd_moment.stdev() << " ";
+  out << hubiness.mean() << " " << hubiness.median() << " " << hubiness.stdev() << " ";
+  out << exp_urlt_hubiness.mean() << " " << exp_urlt_hubiness.median() << " " << exp_urlt_hubiness.stdev() << " ";
+  out << expected_crossings_urlt_minus_star.mean() << " " << expected_crossings_urlt_minus_star.median() << " " << expected_crossings_urlt_minus_star.stdev() << " ";
+  out << crossings_ratio_to_exp_urlt_minus_star.mean() << " " << crossings_ratio_to_exp_urlt_minus_star.median() << " " << crossings_ratio_to_exp_urlt_minus_star.stdev() << " ";
+  out << exp_urlt_hubiness_minus_star.mean() << " " << exp_urlt_hubiness_minus_star.median() << " " << exp_urlt_hubiness_minus_star.stdev() << " ";
+  out << endl;
 
 
 }
@@ -921,23 +1318,29 @@ void compute_detailed_metrics ( std::vector<undirected_graph> graphs , const std
  * Compute optimality (omega) metrics for new project on dependency length minimization.
  * Includes standard deviation, etc.
  */
-void compute_optimality_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix , bool verbose /*= true*/ )
+void compute_optimality_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix , bool verbose /*= true*/ , std::ostream& out /*= cout*/ )
 {
 
   std::size_t sz = graphs.size();
 
 
-  //vectors of metrics for each tree:
-  std::vector<double> length = std::vector<double>(sz,0.0);
-  std::vector<double> D = std::vector<double>(sz,0.0);
-  std::vector<double> D_min = std::vector<double>(sz,0.0);
-  std::vector<double> D_random = std::vector<double>(sz,0.0);
-  std::vector<double> Omega = std::vector<double>(sz,0.0);
+  std::size_t block = std::min( sz , trees_per_block );
+  //statistics of each metric over all trees, computed a block of trees at a time:
+  block_statistics length(block);
+  block_statistics D(block);
+  block_statistics D_min(block);
+  block_statistics D_random(block);
+  block_statistics Omega(block);
   
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
+  std::vector<block_statistics*> metrics = { &length , &D , &D_min , &D_random , &Omega };
+  for ( std::size_t first = 0 ; first < sz ; first += block )
+  {
+  std::size_t last = std::min( sz , first + block );
+  parallel_for ( last - first , 16 , [&] ( std::size_t begin , std::size_t end ) {
+  for ( std::size_t i = first + begin ; i < first + end ; i++ ) 
   {
 
-    undirected_graph graph = graphs[i];
+    const undirected_graph &graph = graphs[i];
     
     //if ( i % 100 == 0 ) cout << i << endl;
 	//write_graph_on_ofstream ( graph , fout );
@@ -945,59 +1348,70 @@ void compute_optimality_detailed_metrics ( std::vector<undirected_graph> graphs
 	//cout << "Tree " << i << " size " << graph.vertices() << endl;
 
     //process graph: current_graph
-    int n = graph.vertices();
-    length[i] = double(n);
+    tree_metrics m = compute_tree_metrics( graph , metric_Omega );
+    length[i] = double(m.n);
 
-    D[i] = graph.edge_length_sum();
-    D_min[i] = graph.minimum_edge_length_sum_of_a_tree();
-    D_random[i] = (n-1)*(n+1)/double(3);
-    Omega[i] = (D_random[i] - D[i])/(D_random[i] - D_min[i]);
+    D[i] = m.D;
+    D_min[i] = m.D_min;
+    D_random[i] = m.D_random;
+    Omega[i] = m.Omega;
 
     assert(-8 <= Omega[i]);
     assert(Omega[i] <= 1);
 
   }
-  cout << setprecision(5);
-
+  } );
 #ifdef DEBUG_OUTPUT
-  for(std::size_t i = 0; i < sz; i++) {
-      undirected_graph g = graphs[i];
-      cout << Omega[i] << ": ";
-	  cout << D[i] << ": ";
-	  cout << D_min[i] << ": ";
-      cout << g.vertices() << " " << g.edges() << " & ";
+  for(std::size_t i = first; i < last; i++) {
+      const undirected_graph &g = graphs[i];
+      out << Omega[i] << ": ";
+	  out << D[i] << ": ";
+	  out << D_min[i] << ": ";
+      out << g.vertices() << " " << g.edges() << " & ";
       for(int u = 0; u < g.vertices(); ++u) {
-	  for(set<int>::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
+	  for(neighbourhood::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
 	      if(u < *i)
-		  cout << u << " " << *i << " # ";
+		  out << u << " " << *i << " # ";
 	  }
       }
-      cout << endl;
+      out << endl;
   }
 #endif
+  for ( std::size_t m = 0 ; m < metrics.size() ; m++ ) metrics[m]->flush( last - first );
+  }
+  output_optimality_statistics ( length , D , D_min , D_random , Omega , linePrefix , verbose , out );
+
+}
+
+/**
+ * Outputs the statistics of the omega metrics of a set of trees, as computed by compute_optimality_detailed_metrics.
+ */
+void output_optimality_statistics ( const running_statistics &length , const running_statistics &D , const running_statistics &D_min , const running_statistics &D_random , const running_statistics &Omega , const std::string& linePrefix , bool verbose , std::ostream& out )
+{
+  out << setprecision(5);
 
   if ( verbose ) 
   {
 
-		if ( !linePrefix.empty() ) cout << linePrefix << endl;
-    cout << "   Number of sentences processed: " << sz << endl;
-    cout << "   Number of vertices ($n$): " << overflow_safe_average(length) << endl;
-    cout << "   Sum of dependency lengths ($D$): " << overflow_safe_average(D) << endl;
-    cout << "   Minimum sum of dependency lengths ($D_{min}$): " << overflow_safe_average(D_min) << endl;
-    cout << "   Expected sum of dependency lengths in a random linear arrangement ($D_{random}$): " << overflow_safe_average(D_random) << endl;
-    cout << "   Optimality measure ($\\Omega$): " << overflow_safe_average(Omega) << endl;
+		if ( !linePrefix.empty() ) out << linePrefix << endl;
+    out << "   Number of sentences processed: " << std::size_t( length.samples() ) << endl;
+    out << "   Number of vertices ($n$): " << length.mean() << endl;
+    out << "   Sum of dependency lengths ($D$): " << D.mean() << endl;
+    out << "   Minimum sum of dependency lengths ($D_{min}$): " << D_min.mean() << endl;
+    out << "   Expected sum of dependency lengths in a random linear arrangement ($D_{random}$): " << D_random.mean() << endl;
+    out << "   Optimality measure ($\\Omega$): " << Omega.mean() << endl;
 
-    cout << "CSV format metrics for table:" << endl;
+    out << "CSV format metrics for table:" << endl;
 
   }
 
-	if ( !linePrefix.empty() ) cout << linePrefix << " ";
-  cout << overflow_safe_average(length) << " " << median(length) << " " << overflow_safe_stdev(length) << " ";
-  cout << overflow_safe_average(D) << " " << median(D) << " " << overflow_safe_stdev(D) << " ";
-  cout << overflow_safe_average(D_min) << " " << median(D_min) << " " << overflow_safe_stdev(D_min) << " ";
-  cout << overflow_safe_average(D_random) << " " << median(D_random) << " " << overflow_safe_stdev(D_random) << " ";
-  cout << overflow_safe_average(Omega) << " " << median(Omega) << " " << overflow_safe_stdev(Omega) << " ";
-  cout << endl;
+	if ( !linePrefix.empty() ) out << linePrefix << " ";
+  out << length.mean() << " " << length.median() << " " << length.stdev() << " ";
+  out << D.mean() << " " << D.median() << " " << D.stdev() << " ";
+  out << D_min.mean() << " " << D_min.median() << " " << D_min.stdev() << " ";
+  out << D_random.mean() << " " << D_random.median() << " " << D_random.stdev() << " ";
+  out << Omega.mean() << " " << Omega.median() << " " << Omega.stdev() << " ";
+  out << endl;
 
 }
 
@@ -1008,27 +1422,32 @@ void compute_optimality_detailed_metrics ( std::vector<undirected_graph> graphs
  * Compute metrics for omega graphs in "classes of grammars" paper: C, D, K2 and Omega (avg and stdev)
  * Includes standard deviation, etc.
  */
-void compute_grammar_optimality_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix , bool verbose /*= true*/ )
+void compute_grammar_optimality_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix , bool verbose /*= true*/ , std::ostream& out /*= cout*/ )
 {
 
   std::size_t sz = graphs.size();
 
 
-  //vectors of metrics for each tree:
-  std::vector<double> length = std::vector<double>(sz,0.0);
-  std::vector<double> D = std::vector<double>(sz,0.0);
-  std::vector<double> D_min = std::vector<double>(sz,0.0);
-  std::vector<double> D_random = std::vector<double>(sz,0.0);
-  std::vector<double> Omega = std::vector<double>(sz,0.0);
-  std::vector<double> crossings = std::vector<double>(sz,0.0);
-  std::vector<double> K2 = std::vector<double>(sz,0.0);
+  std::size_t block = std::min( sz , trees_per_block );
+  //statistics of each metric over all trees, computed a block of trees at a time:
+  block_statistics length(block , no_median);
+  block_statistics D(block , no_median);
+  block_statistics D_min(block , no_median);
+  block_statistics D_random(block , no_median);
+  block_statistics Omega(block , no_median);
+  block_statistics crossings(block , no_median);
+  block_statistics K2(block , no_median);
   
-  bool invalid_length_for_omega = false;
   
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
+  std::vector<block_statistics*> metrics = { &length , &D , &D_min , &D_random , &Omega , &crossings , &K2 };
+  for ( std::size_t first = 0 ; first < sz ; first += block )
+  {
+  std::size_t last = std::min( sz , first + block );
+  parallel_for ( last - first , 16 , [&] ( std::size_t begin , std::size_t end ) {
+  for ( std::size_t i = first + begin ; i < first + end ; i++ ) 
   {
 
-    undirected_graph graph = graphs[i];
+    const undirected_graph &graph = graphs[i];
     
     //if ( i % 100 == 0 ) cout << i << endl;
 	//write_graph_on_ofstream ( graph , fout );
@@ -1036,73 +1455,77 @@ void compute_grammar_optimality_detailed_metrics ( std::vector<undirected_graph>
 	//cout << "Tree " << i << " size " << graph.vertices() << endl;
 
     //process graph: current_graph
-    int n = graph.vertices();
-    if ( n < 3 ) invalid_length_for_omega = true;
+    tree_metrics m = compute_tree_metrics( graph , metric_K2 | metric_C | metric_Omega );
+    int n = m.n;
     length[i] = double(n);
 
-    D[i] = graph.edge_length_sum();
-    D_min[i] = graph.minimum_edge_length_sum_of_a_tree();
-    D_random[i] = (n-1)*(n+1)/double(3);
+    D[i] = m.D;
+    D_min[i] = m.D_min;
+    D_random[i] = m.D_random;
 
     if ( n >= 3 )
     {
-        Omega[i] = (D_random[i] - D[i])/(D_random[i] - D_min[i]);
+        Omega[i] = m.Omega;
         assert(-8 <= Omega[i]);
         assert(Omega[i] <= 1);
     }
     
-    K2[i] = graph.sum_of_squared_degrees();
-    crossings[i] = double(graph.crossings());
+    K2[i] = m.K2;
+    crossings[i] = double(m.C);
 
   }
-  cout << setprecision(5);
-
+  } );
 #ifdef DEBUG_OUTPUT
-  for(std::size_t i = 0; i < sz; i++) {
-      undirected_graph g = graphs[i];
-      cout << Omega[i] << ": ";
-	  cout << D[i] << ": ";
-	  cout << D_min[i] << ": ";
-      cout << g.vertices() << " " << g.edges() << " & ";
+  for(std::size_t i = first; i < last; i++) {
+      const undirected_graph &g = graphs[i];
+      out << Omega[i] << ": ";
+	  out << D[i] << ": ";
+	  out << D_min[i] << ": ";
+      out << g.vertices() << " " << g.edges() << " & ";
       for(int u = 0; u < g.vertices(); ++u) {
-	  for(set<int>::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
+	  for(neighbourhood::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
 	      if(u < *i)
-		  cout << u << " " << *i << " # ";
+		  out << u << " " << *i << " # ";
 	  }
       }
-      cout << endl;
+      out << endl;
   }
 #endif
+  for ( std::size_t m = 0 ; m < metrics.size() ; m++ ) metrics[m]->flush( last - first );
+  }
+
+  bool invalid_length_for_omega = ( sz > 0 && length.min() < 3 );
+  out << setprecision(5);
 
   if ( verbose ) 
   {
 
-		if ( !linePrefix.empty() ) cout << linePrefix << endl;
-    cout << "   Number of sentences processed: " << sz << endl;
-    cout << "   Number of vertices ($n$): " << overflow_safe_average(length) << endl;
-    cout << "   Sum of dependency lengths ($D$): " << overflow_safe_average(D) << endl;
-    cout << "   Minimum sum of dependency lengths ($D_{min}$): " << overflow_safe_average(D_min) << endl;
-    cout << "   Expected sum of dependency lengths in a random linear arrangement ($D_{random}$): " << overflow_safe_average(D_random) << endl;
-    cout << "   Optimality measure ($\\Omega$): " << overflow_safe_average(Omega) << endl;
-    cout << "   Number of crossings ($C$): " << overflow_safe_average(crossings) << endl;
-    cout << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << overflow_safe_average(K2) << endl;
+		if ( !linePrefix.empty() ) out << linePrefix << endl;
+    out << "   Number of sentences processed: " << sz << endl;
+    out << "   Number of vertices ($n$): " << length.mean() << endl;
+    out << "   Sum of dependency lengths ($D$): " << D.mean() << endl;
+    out << "   Minimum sum of dependency lengths ($D_{min}$): " << D_min.mean() << endl;
+    out << "   Expected sum of dependency lengths in a random linear arrangement ($D_{random}$): " << D_random.mean() << endl;
+    out << "   Optimality measure ($\\Omega$): " << Omega.mean() << endl;
+    out << "   Number of crossings ($C$): " << crossings.mean() << endl;
+    out << "   Degree 2nd moment ($\\left< k^2 \\right>$): " << K2.mean() << endl;
 
-    cout << "CSV format metrics for table:" << endl;
+    out << "CSV format metrics for table:" << endl;
 
   }
 
-	if ( !linePrefix.empty() ) cout << linePrefix << " ";
-  //cout << overflow_safe_average(length) << " " << median(length) << " " << overflow_safe_stdev(length) << " ";
-  //cout << overflow_safe_average(D) << " " << median(D) << " " << overflow_safe_stdev(D) << " ";
-  //cout << overflow_safe_average(D_min) << " " << median(D_min) << " " << overflow_safe_stdev(D_min) << " ";
-  //cout << overflow_safe_average(D_random) << " " << median(D_random) << " " << overflow_safe_stdev(D_random) << " ";
-  //cout << overflow_safe_average(Omega) << " " << median(Omega) << " " << overflow_safe_stdev(Omega) << " ";
-  cout << overflow_safe_average(crossings) << " " << overflow_safe_stdev(crossings) << " ";
-  cout << overflow_safe_average(D) << " " << overflow_safe_stdev(D) << " ";
-  cout << overflow_safe_average(K2) << " " << overflow_safe_stdev(K2) << " ";
-  if ( invalid_length_for_omega ) cout << "N/A" << " " << "N/A" << " ";
-  else cout << overflow_safe_average(Omega) << " " << overflow_safe_stdev(Omega) << " ";
-  cout << endl;
+	if ( !linePrefix.empty() ) out << linePrefix << " ";
+  //cout << length.mean() << " " << length.median() << " " << length.stdev() << " ";
+  //cout << D.mean() << " " << D.median() << " " << D.stdev() << " ";
+  //cout << D_min.mean() << " " << D_min.median() << " " << D_min.stdev() << " ";
+  //cout << D_random.mean() << " " << D_random.median() << " " << D_random.stdev() << " ";
+  //cout << Omega.mean() << " " << Omega.median() << " " << Omega.stdev() << " ";
+  out << crossings.mean() << " " << crossings.stdev() << " ";
+  out << D.mean() << " " << D.stdev() << " ";
+  out << K2.mean() << " " << K2.stdev() << " ";
+  if ( invalid_length_for_omega ) out << "N/A" << " " << "N/A" << " ";
+  else out << Omega.mean() << " " << Omega.stdev() << " ";
+  out << endl;
 
 }
 
@@ -1114,22 +1537,28 @@ void compute_grammar_optimality_detailed_metrics ( std::vector<undirected_graph>
  * Compute metrics for new project on anti-DLM on short sentences.
  * Includes standard deviation, etc.
  */
-void compute_antidlm_detailed_metrics ( std::vector<undirected_graph> graphs , const std::string& linePrefix , bool verbose /*= true*/ )
+void compute_antidlm_detailed_metrics ( const treebank_view &graphs , const std::string& linePrefix , bool verbose /*= true*/ , std::ostream& out /*= cout*/ )
 {
 
   std::size_t sz = graphs.size();
 
 
-  //vectors of metrics for each tree:
-  std::vector<double> length = std::vector<double>(sz,0.0);
-  std::vector<double> K2 = std::vector<double>(sz,0.0);
-  std::vector<double> D = std::vector<double>(sz,0.0);
-  std::vector<double> D_min = std::vector<double>(sz,0.0);
+  std::size_t block = std::min( sz , trees_per_block );
+  //statistics of each metric over all trees, computed a block of trees at a time:
+  block_statistics length(block);
+  block_statistics K2(block);
+  block_statistics D(block);
+  block_statistics D_min(block);
   
-  for ( std::size_t i = 0 ; i < sz ; i++ ) 
+  std::vector<block_statistics*> metrics = { &length , &K2 , &D , &D_min };
+  for ( std::size_t first = 0 ; first < sz ; first += block )
+  {
+  std::size_t last = std::min( sz , first + block );
+  parallel_for ( last - first , 16 , [&] ( std::size_t begin , std::size_t end ) {
+  for ( std::size_t i = first + begin ; i < first + end ; i++ ) 
   {
 
-    undirected_graph graph = graphs[i];
+    const undirected_graph &graph = graphs[i];
     
     //if ( i % 100 == 0 ) cout << i << endl;
 	//write_graph_on_ofstream ( graph , fout );
@@ -1137,52 +1566,54 @@ void compute_antidlm_detailed_metrics ( std::vector<undirected_graph> graphs , c
 	//cout << "Tree " << i << " size " << graph.vertices() << endl;
 
     //process graph: current_graph
-    int n = graph.vertices();
-    length[i] = double(n);
+    tree_metrics m = compute_tree_metrics( graph , metric_K2 | metric_D | metric_D_min );
+    length[i] = double(m.n);
 
-    D[i] = graph.edge_length_sum();
-    D_min[i] = graph.minimum_edge_length_sum_of_a_tree();
-    K2[i] = graph.sum_of_squared_degrees();
+    D[i] = m.D;
+    D_min[i] = m.D_min;
+    K2[i] = m.K2;
 
   }
-  cout << setprecision(5);
-
+  } );
 #ifdef DEBUG_OUTPUT
-  for(std::size_t i = 0; i < sz; i++) {
-      undirected_graph g = graphs[i];
-	  cout << D[i] << ": ";
-	  cout << D_min[i] << ": ";
-      cout << g.vertices() << " " << g.edges() << " & ";
+  for(std::size_t i = first; i < last; i++) {
+      const undirected_graph &g = graphs[i];
+	  out << D[i] << ": ";
+	  out << D_min[i] << ": ";
+      out << g.vertices() << " " << g.edges() << " & ";
       for(int u = 0; u < g.vertices(); ++u) {
-	  for(set<int>::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
+	  for(neighbourhood::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
 	      if(u < *i)
-		  cout << u << " " << *i << " # ";
+		  out << u << " " << *i << " # ";
 	  }
       }
-      cout << endl;
+      out << endl;
   }
 #endif
+  for ( std::size_t m = 0 ; m < metrics.size() ; m++ ) metrics[m]->flush( last - first );
+  }
+  out << setprecision(5);
 
   if ( verbose ) 
   {
 
-		if ( !linePrefix.empty() ) cout << linePrefix << endl;
-    cout << "   Number of sentences processed: " << sz << endl;
-    cout << "   Number of vertices ($n$): " << overflow_safe_average(length) << endl;
-    cout << "   Sum of dependency lengths ($D$): " << overflow_safe_average(D) << endl;
-    cout << "   Minimum sum of dependency lengths ($D_{min}$): " << overflow_safe_average(D_min) << endl;
-    cout << "   Sum of squared degrees (K2): " << overflow_safe_average(K2) << endl;
+		if ( !linePrefix.empty() ) out << linePrefix << endl;
+    out << "   Number of sentences processed: " << sz << endl;
+    out << "   Number of vertices ($n$): " << length.mean() << endl;
+    out << "   Sum of dependency lengths ($D$): " << D.mean() << endl;
+    out << "   Minimum sum of dependency lengths ($D_{min}$): " << D_min.mean() << endl;
+    out << "   Sum of squared degrees (K2): " << K2.mean() << endl;
 
-    cout << "CSV format metrics for table:" << endl;
+    out << "CSV format metrics for table:" << endl;
 
   }
 
-  if ( !linePrefix.empty() ) cout << linePrefix << " ";
-  cout << overflow_safe_average(length) << " " << median(length) << " " << overflow_safe_stdev(length) << " ";
-  cout << overflow_safe_average(D) << " " << median(D) << " " << overflow_safe_stdev(D) << " ";
-  cout << overflow_safe_average(D_min) << " " << median(D_min) << " " << overflow_safe_stdev(D_min) << " ";
-  cout << overflow_safe_average(K2) << " " << median(K2) << " " << overflow_safe_stdev(K2) << " ";
-  cout << endl;
+  if ( !linePrefix.empty() ) out << linePrefix << " ";
+  out << length.mean() << " " << length.median() << " " << length.stdev() << " ";
+  out << D.mean() << " " << D.median() << " " << D.stdev() << " ";
+  out << D_min.mean() << " " << D_min.median() << " " << D_min.stdev() << " ";
+  out << K2.mean() << " " << K2.median() << " " << K2.stdev() << " ";
+  out << endl;
 
 }
 
@@ -1475,6 +1906,20 @@ std::string get_iso_code ( std::string language_or_filename )
       return "unk";
 }
 
+//FNV-1a hash of the name of a file without its directory, so that the seed of its trees does not depend
+//on where the file is or on the order in which the directory is listed
+unsigned long long file_name_seed ( const std::string& file_name )
+{
+  std::string base_name = file_name.substr( file_name.find_last_of("/\\") + 1 );
+  unsigned long long h = 14695981039346656037ULL;
+  for ( std::size_t i = 0 ; i < base_name.size() ; i++ )
+  {
+    h ^= (unsigned char)(base_name[i]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
 //determine if string ends with given suffix
 int ends_with(const char *str, const char *suffix)
 {
@@ -0,0 +1,281 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+// Micro-benchmarks of the metric kernels, to track regressions: every kernel is
+// run over synthetic trees of a given family and size (paths, stars, uniformly
+// random labelled trees and caterpillars, with their vertices placed in a
+// uniformly random order, see random_trees.hpp) and the time is reported in
+// ns/tree and trees/s.
+// The parsing of .heads files is measured on the files given, and the
+// construction of the tables of probabilities of crossing on every size.
+//
+// Usage: benchmark [--trees k] [--min-time s] [--seed x] [--json file] [heads file ...]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "undirected_graph.hpp"
+#include "probability_of_crossing_knowing_edge_lengths.hpp"
+#include "heads_file.hpp"
+#include "tree_metrics.hpp"
+#include "random_trees.hpp"
+
+using namespace std;
+
+struct benchmark_result
+{
+  std::string kernel;
+  std::string family;
+  double n; //mean number of vertices of the trees
+  long long trees; //trees processed, counting every repetition
+  double seconds;
+};
+
+static const int sizes[] = { 10 , 30 , 100 , 300 };
+static const char * families[] = { "path" , "star" , "random" , "caterpillar" };
+
+static int trees_per_set = 1000;
+static double min_seconds = 0.2;
+static unsigned long long seed = 1;
+static long long checksum = 0; //so that the results of the kernels are not optimized away
+
+//the heads of a tree of the family, with every vertex v at position v
+void tree_of_family ( const std::string & family , int n , int * heads , mt19937_64 & random )
+{
+  if ( family == "random" )
+  {
+    uniformly_random_tree( n , heads , random );
+    return;
+  }
+  heads[0] = 0;
+  if ( family == "path" )
+  {
+    for ( int v = 1 ; v < n ; v++ )
+      heads[v] = v;
+  }
+  else if ( family == "star" )
+  {
+    for ( int v = 1 ; v < n ; v++ )
+      heads[v] = 1;
+  }
+  else
+  {
+    //a path of half of the vertices, the others hanging from random vertices of the path
+    int spine = std::max( 1 , n / 2 );
+    for ( int v = 1 ; v < spine ; v++ )
+      heads[v] = v;
+    for ( int v = spine ; v < n ; v++ )
+      heads[v] = int( random() % spine ) + 1;
+  }
+}
+
+//runs kernel(i) for i = 0, ..., count-1, as many times as needed to take at least min_seconds
+benchmark_result time_kernel ( const std::string & kernel , const std::string & family , double n , std::size_t count , const std::function<long long(std::size_t)> & f )
+{
+  benchmark_result r;
+  r.kernel = kernel;
+  r.family = family;
+  r.n = n;
+  r.trees = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  do
+  {
+    for ( std::size_t i = 0 ; i < count ; i++ )
+      checksum += f(i);
+    r.trees += count;
+    r.seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+  } while ( r.seconds < min_seconds && count > 0 );
+  return r;
+}
+
+void output_results ( const std::vector<benchmark_result> & results , ostream & out )
+{
+  out << std::left << std::setw(28) << "kernel" << std::setw(20) << "family" << std::right << std::setw(8) << "n"
+      << std::setw(14) << "ns/tree" << std::setw(14) << "trees/s" << endl;
+  for ( std::size_t i = 0 ; i < results.size() ; i++ )
+  {
+    const benchmark_result & r = results[i];
+    out << std::left << std::setw(28) << r.kernel << std::setw(20) << r.family << std::right << std::fixed
+        << std::setprecision(1) << std::setw(8) << r.n << std::setw(14) << 1e9*r.seconds/r.trees
+        << std::setprecision(0) << std::setw(14) << r.trees/r.seconds << endl;
+  }
+}
+
+//JSON string of a file name or an identifier: only quotes, backslashes and control characters need escaping
+std::string json_string ( const std::string & s )
+{
+  std::string quoted = "\"";
+  for ( std::size_t i = 0 ; i < s.size() ; i++ )
+  {
+    unsigned char c = s[i];
+    if ( c == '"' || c == '\\' ) quoted += '\\';
+    if ( c < 0x20 )
+    {
+      char escape[8];
+      snprintf( escape , sizeof(escape) , "\\u%04x" , c );
+      quoted += escape;
+    }
+    else quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void output_results_as_json ( const std::vector<benchmark_result> & results , ostream & out )
+{
+  out << "{\n  \"trees_per_set\": " << trees_per_set << ",\n  \"min_seconds\": " << min_seconds
+      << ",\n  \"seed\": " << seed << ",\n  \"results\": [\n";
+  for ( std::size_t i = 0 ; i < results.size() ; i++ )
+  {
+    const benchmark_result & r = results[i];
+    out << "    {\"kernel\": " << json_string(r.kernel) << ", \"family\": " << json_string(r.family)
+        << ", \"n\": " << r.n << ", \"trees\": " << r.trees << ", \"seconds\": " << r.seconds
+        << ", \"ns_per_tree\": " << 1e9*r.seconds/r.trees << ", \"trees_per_second\": " << r.trees/r.seconds
+        << "}" << ( i + 1 < results.size() ? "," : "" ) << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+int main ( int argc , char * argv[] )
+{
+  const char * json_file = NULL;
+  std::vector<std::string> heads_files;
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    if ( !strcmp( argv[i] , "--trees" ) && i + 1 < argc )
+      trees_per_set = std::max( 1 , atoi(argv[++i]) );
+    else if ( !strcmp( argv[i] , "--min-time" ) && i + 1 < argc )
+      min_seconds = atof(argv[++i]);
+    else if ( !strcmp( argv[i] , "--seed" ) && i + 1 < argc )
+      seed = strtoull( argv[++i] , NULL , 10 );
+    else if ( !strcmp( argv[i] , "--json" ) && i + 1 < argc )
+      json_file = argv[++i];
+    else if ( argv[i][0] == '-' )
+    {
+      cerr << "Usage: " << argv[0] << " [--trees k] [--min-time s] [--seed x] [--json file] [heads file ...]" << endl;
+      return 1;
+    }
+    else
+      heads_files.push_back( argv[i] );
+  }
+
+  std::vector<benchmark_result> results;
+  mt19937_64 & random = random_generator();
+  seed_random_generator( seed );
+  for ( std::size_t s = 0 ; s < sizeof(sizes)/sizeof(sizes[0]) ; s++ )
+  {
+    int n = sizes[s];
+    const probability_of_crossing_knowing_edge_lengths & table = probability_of_crossing_table(n);
+    for ( std::size_t f = 0 ; f < sizeof(families)/sizeof(families[0]) ; f++ )
+    {
+      std::string family = families[f];
+      std::vector<std::vector<int> > heads( trees_per_set , std::vector<int>( n ) );
+      std::vector<undirected_graph> graphs( trees_per_set );
+      std::vector<int> tree( n ) , position( n );
+      for ( int t = 0 ; t < trees_per_set ; t++ )
+      {
+        tree_of_family( family , n , tree.data() , random );
+        uniformly_random_arrangement( n , position.data() , random );
+        arrange_tree( n , tree.data() , position.data() , heads[t].data() );
+        graphs[t] = undirected_graph( heads[t] );
+      }
+      results.push_back( time_kernel( "crossings" , family , n , graphs.size() , [&] ( std::size_t t ) {
+        return graphs[t].crossings();
+      } ) );
+      results.push_back( time_kernel( "fully_predicted_crossings" , family , n , graphs.size() , [&] ( std::size_t t ) {
+        return (long long)( graphs[t].fully_predicted_crossings(table) );
+      } ) );
+      results.push_back( time_kernel( "minimum_edge_length_sum" , family , n , graphs.size() , [&] ( std::size_t t ) {
+        return graphs[t].minimum_edge_length_sum_of_a_tree();
+      } ) );
+      results.push_back( time_kernel( "tree_metrics" , family , n , heads.size() , [&] ( std::size_t t ) {
+        tree_metrics m = compute_tree_metrics( heads[t].data() , n , all_tree_metrics );
+        return (long long)( m.K2 + m.D + m.D_min + m.C );
+      } ) );
+    }
+    //the synthetic load itself: a random tree in a random order, in the same buffers every time
+    std::vector<int> tree( n ) , position( n ) , arranged( n );
+    results.push_back( time_kernel( "random_arranged_tree" , "random" , n , trees_per_set , [&] ( std::size_t ) {
+      uniformly_random_tree( n , tree.data() , random );
+      uniformly_random_arrangement( n , position.data() , random );
+      arrange_tree( n , tree.data() , position.data() , arranged.data() );
+      return (long long)( arranged[0] );
+    } ) );
+    //a new table every time, not the one in the cache
+    results.push_back( time_kernel( "probability_table" , "table" , n , 1 , [&] ( std::size_t ) {
+      probability_of_crossing_knowing_edge_lengths p(n);
+      return (long long)( 1000*p.probability_of_crossing( 1 , 1 ) );
+    } ) );
+  }
+
+  for ( std::size_t i = 0 ; i < heads_files.size() ; i++ )
+  {
+    const char * name = heads_files[i].c_str();
+    std::vector<int> heads;
+    std::vector<std::size_t> offset;
+    heads_file file( name );
+    if ( !file.good() )
+    {
+      cerr << "Problem with " << name << endl;
+      continue;
+    }
+    file.read_trees( heads , offset );
+    std::size_t trees = offset.size() - 1;
+    if ( trees == 0 ) continue;
+    //every repetition parses the whole file again
+    benchmark_result r = time_kernel( "heads_parsing" , name , double(heads.size())/trees , 1 , [&] ( std::size_t ) {
+      heads_file again( name );
+      std::vector<int> h;
+      h.reserve( heads.size() );
+      long long read = 0;
+      while ( again.read_tree(h) ) read++;
+      return read;
+    } );
+    r.trees *= trees;
+    results.push_back( r );
+    results.push_back( time_kernel( "tree_metrics" , name , double(heads.size())/trees , trees , [&] ( std::size_t t ) {
+      tree_metrics m = compute_tree_metrics( heads.data() + offset[t] , int( offset[t+1] - offset[t] ) , all_tree_metrics );
+      return (long long)( m.K2 + m.D + m.D_min + m.C );
+    } ) );
+  }
+
+  output_results( results , cout );
+  cerr << "checksum " << checksum << endl;
+  if ( json_file != NULL )
+  {
+    ofstream json( json_file );
+    output_results_as_json( results , json );
+    if ( !json )
+    {
+      cerr << "Problem with " << json_file << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include "buffered_writer.hpp"
+
+buffered_writer::buffered_writer(ostream &out, size_t buffer_size): out(out), buffer(buffer_size), used(0) {
+   assert(buffer_size >= max_number_length);
+}
+
+buffered_writer::~buffered_writer() {
+   flush();
+}
+
+buffered_writer &buffered_writer::operator<<(const char *s) {
+   size_t length = strlen(s);
+   if (used + length > buffer.size()) {
+      flush();
+      // too long for the buffer: straight to the stream
+      if (length > buffer.size()) {
+         out.write(s, length);
+         return *this;
+      }
+   }
+   memcpy(buffer.data() + used, s, length);
+   used += length;
+   return *this;
+}
+
+buffered_writer &buffered_writer::operator<<(const string &s) {
+   return *this << s.c_str();
+}
+
+void buffered_writer::flush() {
+   out.write(buffer.data(), used);
+   used = 0;
+}
@@ -0,0 +1,100 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _BUFFERED_WRITER_
+#define _BUFFERED_WRITER_
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Formats numbers into a large buffer that is written to a stream in blocks,
+ * for the files with the metrics of every tree. Doubles are written with the
+ * shortest representation that reads back as the same double (to_chars), so
+ * they survive a round trip like with setprecision(17) but are usually
+ * shorter. Doubles with an integer value are written as integers, as
+ * setprecision(17) does (to_chars alone would write 100000 as 1e+05). Nothing is flushed at the end of a line; the buffer is written
+ * when it is full, by flush and by the destructor.
+ */
+class buffered_writer {
+private:
+   ostream &out;
+   vector<char> buffer;
+   size_t used;
+   static const size_t max_number_length = 32; // of a double or an integer written by to_chars
+   template<class T> buffered_writer &write_number(T x);
+public:
+   buffered_writer(ostream &out, size_t buffer_size = 1 << 16);
+   ~buffered_writer();
+   buffered_writer &operator<<(double x);
+   buffered_writer &operator<<(int x);
+   buffered_writer &operator<<(long x);
+   buffered_writer &operator<<(unsigned long x);
+   buffered_writer &operator<<(char c);
+   buffered_writer &operator<<(const char *s);
+   buffered_writer &operator<<(const string &s);
+   // Post: everything written so far has been passed to the stream (which is not flushed)
+   void flush();
+};
+
+template<class T> inline buffered_writer &buffered_writer::write_number(T x) {
+   if (used + max_number_length > buffer.size()) flush();
+   to_chars_result r = to_chars(buffer.data() + used, buffer.data() + buffer.size(), x);
+   used = r.ptr - buffer.data();
+   return *this;
+}
+
+inline buffered_writer &buffered_writer::operator<<(double x) {
+   if (x < 1e17 and x > -1e17 and x == (long long)x) {
+      if (x == 0 and signbit(x)) return *this << "-0";
+      return write_number((long long)x);
+   }
+   return write_number(x);
+}
+
+inline buffered_writer &buffered_writer::operator<<(int x) {
+   return write_number(x);
+}
+
+inline buffered_writer &buffered_writer::operator<<(long x) {
+   return write_number(x);
+}
+
+inline buffered_writer &buffered_writer::operator<<(unsigned long x) {
+   return write_number(x);
+}
+
+inline buffered_writer &buffered_writer::operator<<(char c) {
+   if (used == buffer.size()) flush();
+   buffer[used++] = c;
+   return *this;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+// Differential check of the two implementations of Shiloach's algorithm:
+// calculate_D_min_Shiloach, used by the metrics, against the original
+// calculate_D_min_Shiloach_matrix, on uniformly random labelled trees of
+// several sizes (see random_trees.hpp) and on the trees of the .heads files
+// given. It stops at the first tree on which they differ.
+//
+// Usage: check_D_min [--trees k] [--seed x] [heads file ...]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+#include "common.hpp"
+#include "heads_file.hpp"
+#include "random_trees.hpp"
+
+using namespace std;
+
+static const int sizes[] = { 1 , 2 , 3 , 4 , 5 , 8 , 13 , 30 , 100 , 300 };
+
+//Pre: heads are the heads of a tree of n vertices, as in a .heads file
+//Post: true if both implementations give the same minimum sum of edge lengths
+bool same_D_min ( const int * heads , int n )
+{
+  edge_vector edges;
+  for ( int v = 0 ; v < n ; v++ )
+    if ( heads[v] != 0 ) edges.push_back( pair<uint32_t,uint32_t>( v + 1 , heads[v] ) );
+  list<pair<uint32_t,uint32_t> > l( edges.begin() , edges.end() );
+  uint32_t D_min = calculate_D_min_Shiloach( n , edges );
+  uint32_t D_min_matrix = calculate_D_min_Shiloach_matrix( n , l );
+  if ( D_min == D_min_matrix ) return true;
+  cerr << "D_min " << D_min << " instead of " << D_min_matrix << " for the heads";
+  for ( int v = 0 ; v < n ; v++ ) cerr << " " << heads[v];
+  cerr << endl;
+  return false;
+}
+
+int main ( int argc , char * argv[] )
+{
+  int trees = 1000;
+  unsigned long long seed = 1;
+  std::vector<std::string> heads_files;
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    if ( !strcmp( argv[i] , "--trees" ) && i + 1 < argc )
+      trees = std::max( 1 , atoi(argv[++i]) );
+    else if ( !strcmp( argv[i] , "--seed" ) && i + 1 < argc )
+      seed = strtoull( argv[++i] , NULL , 10 );
+    else if ( argv[i][0] == '-' )
+    {
+      cerr << "Usage: " << argv[0] << " [--trees k] [--seed x] [heads file ...]" << endl;
+      return 1;
+    }
+    else
+      heads_files.push_back( argv[i] );
+  }
+
+  mt19937_64 random( seed );
+  long long checked = 0;
+  for ( std::size_t s = 0 ; s < sizeof(sizes)/sizeof(sizes[0]) ; s++ )
+  {
+    int n = sizes[s];
+    std::vector<int> heads( n );
+    //the matrix version takes O(n^3) time: fewer of the largest trees
+    int k = n <= 30 ? trees : std::max( 1 , trees/n );
+    for ( int t = 0 ; t < k ; t++ , checked++ )
+    {
+      uniformly_random_tree( n , heads.data() , random );
+      if ( !same_D_min( heads.data() , n ) ) return 1;
+    }
+  }
+  for ( std::size_t f = 0 ; f < heads_files.size() ; f++ )
+  {
+    heads_file file( heads_files[f].c_str() );
+    if ( !file.good() )
+    {
+      cerr << "Problem with " << heads_files[f] << endl;
+      return 1;
+    }
+    std::vector<int> heads;
+    while ( file.read_tree( heads ) )
+    {
+      if ( !heads.empty() && !same_D_min( heads.data() , heads.size() ) ) return 1;
+      checked++;
+      heads.clear();
+    }
+  }
+  cout << "D_min is the same for the " << checked << " trees" << endl;
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+// Checks of E[C|D], the mean number of crossings over the arrangements of a
+// tree with its sum of edge lengths D, against the exact distribution of D and
+// C of lengths_and_crossings_distribution:
+// - the enumeration of crossings_at_constant_sum_of_lengths, on uniformly
+//   random trees in uniformly random arrangements of up to 9 vertices, with a
+//   single thread and split into tasks for k threads (4 by default), which
+//   must give the same value;
+// - the Markov chain of sample_crossings_at_constant_sum_of_lengths, on
+//   uniformly random trees of 10 to 16 vertices arranged at D_min or a few
+//   units above it, where the arrangements with the same sum of lengths are
+//   fewest and farthest apart: at least 80% of the 95% confidence intervals
+//   must contain the exact value, and none may be more than 6 standard errors
+//   away from it.
+// It stops at the first tree that fails.
+//
+// Usage: check_crossings_at_constant_sum_of_lengths [--trees k] [--seed x] [--threads k]
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "undirected_graph.hpp"
+#include "fast_prediction_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "lengths_and_crossings_distribution.hpp"
+#include "sampling_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "random_trees.hpp"
+#include "thread_pool.hpp"
+
+using namespace std;
+
+static const int enumerated_sizes[] = { 4 , 5 , 6 , 7 , 8 , 9 };
+static const int sampled_sizes[] = { 10 , 12 , 14 , 16 };
+//attempts of the local search for an arrangement at D_min
+static const int restarts_max = 1000;
+
+void print_heads ( const std::vector<int> & heads )
+{
+  for ( std::size_t v = 0 ; v < heads.size() ; v++ ) cerr << " " << heads[v];
+  cerr << endl;
+}
+
+//Post: arranged are the heads of the tree of heads in an arrangement with the minimum sum of edge
+//      lengths, found by local search (swaps of two vertices) from random arrangements; false if
+//      none was found
+bool minimum_arrangement ( const std::vector<int> & heads , std::vector<int> & arranged , mt19937_64 & random )
+{
+  int n = heads.size();
+  int D_min = undirected_graph( heads ).minimum_edge_length_sum_of_a_tree();
+  std::vector<int> position( n );
+  for ( int r = 0 ; r < restarts_max ; r++ )
+  {
+    uniformly_random_arrangement( n , position.data() , random );
+    arrange_tree( n , heads.data() , position.data() , arranged.data() );
+    int D = undirected_graph( arranged ).edge_length_sum();
+    bool improved = true;
+    while ( improved && D > D_min )
+    {
+      improved = false;
+      for ( int u = 0 ; u < n && !improved ; u++ )
+        for ( int v = u + 1 ; v < n && !improved ; v++ )
+        {
+          swap( position[u] , position[v] );
+          arrange_tree( n , heads.data() , position.data() , arranged.data() );
+          int D_swapped = undirected_graph( arranged ).edge_length_sum();
+          if ( D_swapped < D )
+          {
+            D = D_swapped;
+            improved = true;
+          }
+          else
+            swap( position[u] , position[v] );
+        }
+    }
+    if ( D == D_min )
+    {
+      arrange_tree( n , heads.data() , position.data() , arranged.data() );
+      return true;
+    }
+  }
+  return false;
+}
+
+//Post: if some swap of two positions of the arrangement of heads increases its sum of edge lengths by
+//      exactly increase, heads are those of the first such arrangement, and true is returned
+bool increase_sum_of_lengths ( std::vector<int> & heads , int increase )
+{
+  int n = heads.size();
+  int D = undirected_graph( heads ).edge_length_sum();
+  std::vector<int> position( n ) , swapped( n );
+  for ( int v = 0 ; v < n ; v++ ) position[v] = v;
+  for ( int u = 0 ; u < n ; u++ )
+    for ( int v = u + 1 ; v < n ; v++ )
+    {
+      swap( position[u] , position[v] );
+      arrange_tree( n , heads.data() , position.data() , swapped.data() );
+      swap( position[u] , position[v] );
+      if ( undirected_graph( swapped ).edge_length_sum() == D + increase )
+      {
+        heads = swapped;
+        return true;
+      }
+    }
+  return false;
+}
+
+int main ( int argc , char * argv[] )
+{
+  int trees = 20;
+  unsigned long long seed = 1;
+  int threads = 4;
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    if ( !strcmp( argv[i] , "--trees" ) && i + 1 < argc )
+      trees = std::max( 1 , atoi(argv[++i]) );
+    else if ( !strcmp( argv[i] , "--seed" ) && i + 1 < argc )
+      seed = strtoull( argv[++i] , NULL , 10 );
+    else if ( !strcmp( argv[i] , "--threads" ) && i + 1 < argc )
+      threads = std::max( 2 , atoi(argv[++i]) );
+    else
+    {
+      cerr << "Usage: " << argv[0] << " [--trees k] [--seed x] [--threads k]" << endl;
+      return 1;
+    }
+  }
+
+  mt19937_64 random( seed );
+  int enumerated = 0;
+  for ( std::size_t s = 0 ; s < sizeof(enumerated_sizes)/sizeof(enumerated_sizes[0]) ; s++ )
+  {
+    int n = enumerated_sizes[s];
+    std::vector<int> heads( n ) , position( n ) , arranged( n );
+    for ( int t = 0 ; t < trees ; t++ , enumerated++ )
+    {
+      uniformly_random_tree( n , heads.data() , random );
+      uniformly_random_arrangement( n , position.data() , random );
+      arrange_tree( n , heads.data() , position.data() , arranged.data() );
+      undirected_graph g( arranged );
+      int D = g.edge_length_sum();
+      set_threads( 1 );
+      double mean = crossings_at_constant_sum_of_lengths( g );
+      set_threads( threads );
+      double parallel_mean = crossings_at_constant_sum_of_lengths( g );
+      set_threads( 1 );
+      if ( parallel_mean != mean )
+      {
+        cerr << "E[C|D] " << parallel_mean << " with " << threads << " threads instead of " << mean << " for the heads";
+        print_heads( arranged );
+        return 1;
+      }
+      double exact = lengths_and_crossings_distribution( g , D ).crossings_given_sum_of_lengths( D ).mean();
+      if ( fabs( mean - exact ) > 1e-9*std::max( 1.0 , exact ) )
+      {
+        cerr << "E[C|D] " << mean << " instead of " << exact << " for the heads";
+        print_heads( arranged );
+        return 1;
+      }
+    }
+  }
+  cout << "The enumeration of E[C|D] is exact for the " << enumerated << " trees, with 1 and " << threads << " threads" << endl;
+
+  crossings_sampling sampling;
+  for ( std::size_t s = 0 ; s < sizeof(sampled_sizes)/sizeof(sampled_sizes[0]) ; s++ )
+  {
+    int n = sampled_sizes[s];
+    int sampled = 0 , covered = 0;
+    std::vector<int> heads( n ) , arranged( n );
+    for ( int t = 0 ; t < trees ; t++ )
+    {
+      uniformly_random_tree( n , heads.data() , random );
+      //D_min, D_min + 1, D_min + 2 and D_min + 3 in turns
+      if ( !minimum_arrangement( heads , arranged , random ) || !increase_sum_of_lengths( arranged , t % 4 ) ) continue;
+      undirected_graph g( arranged );
+      int D = g.edge_length_sum();
+      double exact = lengths_and_crossings_distribution( g , D ).crossings_given_sum_of_lengths( D ).mean();
+      mt19937_64 chain_random( seed + t );
+      crossings_estimate e = sample_crossings_at_constant_sum_of_lengths( g , sampling , chain_random );
+      if ( e.samples == 0 || fabs( e.mean - exact ) > 6*e.standard_error + 1e-9 )
+      {
+        cerr << "E[C|D] " << e.mean << " (standard error " << e.standard_error << ", " << e.samples << " samples) instead of " << exact << " for the heads";
+        print_heads( arranged );
+        return 1;
+      }
+      sampled++;
+      if ( e.lower - 1e-9 <= exact && exact <= e.upper + 1e-9 ) covered++;
+    }
+    cout << "n = " << n << ": the 95% confidence interval of the sampled E[C|D] contains the exact value for " << covered << " of " << sampled << " trees near D_min" << endl;
+    if ( covered < 0.8*sampled )
+    {
+      cerr << "Too few confidence intervals contain the exact value" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -132,3 +132,90 @@ void convert_tree_to_matrix(uint32_t n,const list<pair<uint32_t,uint32_t> > & t,
 	}
 }
 
+tree_adjacency::tree_adjacency(uint32_t n, const edge_vector & t, pmr::memory_resource * m)
+	: first(m), arc(m), alive(m), stack(m), preorder(m), parent(m), size(m)
+{
+	first.assign(n+2,0);
+	for (uint32_t i=0;i<t.size();++i){
+		++first[t[i].first+1];
+		++first[t[i].second+1];
+	}
+	for (uint32_t u=1;u<=n;++u) first[u+1]+=first[u];
+	arc.resize(2*t.size());
+	alive.assign(2*t.size(),1);
+	pmr::vector<uint32_t> next(first,m);
+	for (uint32_t i=0;i<t.size();++i){
+		arc[next[t[i].first]++]=t[i].second;
+		arc[next[t[i].second]++]=t[i].first;
+	}
+	for (uint32_t u=1;u<=n;++u) sort(arc.begin()+first[u],arc.begin()+first[u+1]);
+	parent.assign(n+1,0);
+	size.assign(n+1,0);
+	preorder.reserve(n);
+	stack.reserve(n);
+}
+
+void tree_adjacency::set_edge(uint32_t u, uint32_t v, char value)
+{
+	uint32_t a=lower_bound(arc.begin()+first[u],arc.begin()+first[u+1],v)-arc.begin();
+	uint32_t b=lower_bound(arc.begin()+first[v],arc.begin()+first[v+1],u)-arc.begin();
+	assert(a<first[u+1] and arc[a]==v);
+	assert(b<first[v+1] and arc[b]==u);
+	alive[a]=alive[b]=value;
+}
+
+void tree_adjacency::cut(uint32_t u, uint32_t v)
+{
+	set_edge(u,v,0);
+}
+
+void tree_adjacency::join(uint32_t u, uint32_t v)
+{
+	set_edge(u,v,1);
+}
+
+uint32_t tree_adjacency::root_subtree(uint32_t root)
+// Nodes reachable from root in the same order as reachable_nodes,
+// and the size of the subtrees rooted at each of them.
+{
+	preorder.clear();
+	stack.assign(1,root);
+	parent[root]=0;
+	while (not stack.empty()){
+		uint32_t u=stack.back();
+		stack.pop_back();
+		preorder.push_back(u);
+		size[u]=1;
+		for (uint32_t a=first[u+1];a>first[u];--a){
+			uint32_t v=arc[a-1];
+			if (alive[a-1] and v!=parent[u]){
+				parent[v]=u;
+				stack.push_back(v);
+			}
+		}
+	}
+	for (uint32_t i=preorder.size()-1;i>0;--i){
+		uint32_t u=preorder[i];
+		size[parent[u]]+=size[u];
+	}
+	return preorder.size();
+}
+
+uint32_t tree_adjacency::size_of_subtree(uint32_t u, uint32_t v) const
+// Size of the subtree rooted in v in the tree rooted in u, 
+// v a neighbour of u (after root_subtree)
+{
+	if (parent[u]==v) return size[preorder[0]]-size[u];
+	assert(parent[v]==u);
+	return size[v];
+}
+
+void tree_adjacency::order_subtrees_by_size(uint32_t root, ordering & ord) const
+{
+	assert(ord.size()==0); // Ordering should be empty
+	for (uint32_t a=first[root];a<first[root+1];++a){
+		if (alive[a]) ord.push_back(pair<uint32_t,uint32_t>(size_of_subtree(root,arc[a]),arc[a]));
+	}
+	sort(ord.begin(),ord.end(),order_pair);
+}
+
@@ -33,6 +33,7 @@
 #include <vector>
 #include <algorithm>
 #include <list>
+#include <memory_resource>
 #include <cmath>
 #include <cassert>
 using namespace std;
@@ -57,11 +58,46 @@ typedef vector<vector<uint32_t> > size_matrix;
 // In one matrix there can be several
 // unconnected trees.
 
-typedef vector<pair<uint32_t,uint32_t> > ordering;
+typedef pmr::vector<pair<uint32_t,uint32_t> > ordering;
 // Elements are size and root of subtrees ordered by size
 
-typedef vector<pair<uint32_t,uint32_t> > edge_vector;
+typedef pmr::vector<pair<uint32_t,uint32_t> > edge_vector;
 // Vector with all edges
+// Both take their memory from new unless they are given a resource,
+// like tree_scratch() for the scratch memory of one tree.
+
+class tree_adjacency
+// Adjacency lists of a tree whose edges can be cut and joined again.
+// Nodes are labelled 1, 2, ..., n as in adjacency_matrix.
+// The arcs leaving u are arc[first[u]], ..., arc[first[u+1]-1],
+// in increasing order of the node they point to.
+{
+private:
+	pmr::vector<uint32_t> first;
+	pmr::vector<uint32_t> arc; // node the arc points to
+	pmr::vector<char> alive; // false if the edge of the arc has been cut
+	pmr::vector<uint32_t> stack; // used by root_subtree
+	void set_edge(uint32_t u, uint32_t v, char value);
+public:
+	// Filled by root_subtree for the nodes reachable from the root
+	pmr::vector<uint32_t> preorder; 
+	pmr::vector<uint32_t> parent; 
+	pmr::vector<uint32_t> size; // size of the subtree rooted in the node
+	
+	// All the vectors take their memory from m
+	tree_adjacency(uint32_t n, const edge_vector & t, pmr::memory_resource * m = pmr::get_default_resource());
+	pmr::memory_resource * memory() const { return first.get_allocator().resource(); }
+	void cut(uint32_t u, uint32_t v);
+	void join(uint32_t u, uint32_t v);
+	// O(size of the component of root), every time it is called
+	uint32_t root_subtree(uint32_t root);
+	uint32_t size_of_subtree(uint32_t u, uint32_t v) const;
+	void order_subtrees_by_size(uint32_t root, ordering & ord) const;
+	uint32_t begin(uint32_t u) const { return first[u]; }
+	uint32_t end(uint32_t u) const { return first[u+1]; }
+	uint32_t node(uint32_t a) const { return arc[a]; }
+	bool is_cut(uint32_t a) const { return not alive[a]; }
+};
 
 void size_of_all_subtrees_from_one_node(adjacency_matrix & g,vector<uint32_t> &v, uint32_t id_root);
 
@@ -75,4 +111,6 @@ void order_subtrees_by_size(const adjacency_matrix & g, vector<uint32_t> & s, ui
 
 void convert_tree_to_matrix(uint32_t n,const list<pair<uint32_t,uint32_t> > & t, adjacency_matrix & g);
 
-uint32_t calculate_D_min_Shiloach(uint32_t n, list<pair<uint32_t,uint32_t> >&tree);
+uint32_t calculate_D_min_Shiloach_matrix(uint32_t n, list<pair<uint32_t,uint32_t> >&tree);
+
+uint32_t calculate_D_min_Shiloach(uint32_t n, const edge_vector & tree);
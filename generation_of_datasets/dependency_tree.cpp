@@ -0,0 +1,96 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include "dependency_tree.hpp"
+
+int dependency_tree::edges() const {
+   int edges = 0;
+   for (int v = 0; v < n; ++v) edges += head(v) >= 0;
+   return edges;
+}
+
+int dependency_tree::edge_length_sum() const {
+   int sum = 0;
+   for (int v = 0; v < n; ++v) sum += edge_length(v);
+   return sum;
+}
+
+int dependency_tree::sum_of_squared_degrees() const {
+   pmr::vector<int> degree;
+   degrees(degree);
+   int sum = 0;
+   for (int v = 0; v < n; ++v) sum += degree[v]*degree[v];
+   return sum;
+}
+
+void dependency_tree::degrees(pmr::vector<int> &degree) const {
+   degree.assign(n, 0);
+   for (int v = 0; v < n; ++v) {
+      int h = head(v);
+      if (h >= 0) {
+         ++degree[v];
+         ++degree[h];
+      }
+   }
+}
+
+void dependency_tree::children(pmr::vector<int> &first, pmr::vector<int> &child) const {
+   // counting sort of the vertices by head
+   first.assign(n + 1, 0);
+   for (int v = 0; v < n; ++v) {
+      if (head(v) >= 0) ++first[head(v) + 1];
+   }
+   for (int v = 0; v < n; ++v) first[v + 1] += first[v];
+   child.resize(first[n]);
+   pmr::vector<int> next(first.begin(), first.end() - 1, first.get_allocator());
+   for (int v = 0; v < n; ++v) {
+      if (head(v) >= 0) child[next[head(v)]++] = v;
+   }
+}
+
+void dependency_tree::edges_by_left_endpoint(pmr::vector<int> &first, pmr::vector<int> &right) const {
+   // counting sort of the edges by their left endpoint
+   first.assign(n + 1, 0);
+   for (int v = 0; v < n; ++v) {
+      int h = head(v);
+      if (h >= 0) ++first[min(v, h) + 1];
+   }
+   for (int i = 0; i < n; ++i) first[i + 1] += first[i];
+   right.resize(first[n]);
+   pmr::vector<int> next(first.begin(), first.end() - 1, first.get_allocator());
+   for (int v = 0; v < n; ++v) {
+      int h = head(v);
+      if (h >= 0) right[next[min(v, h)]++] = max(v, h);
+   }
+}
+
+void dependency_tree::edge_list(edge_vector &edges) const {
+   edges.clear();
+   for (int v = 0; v < n; ++v) {
+      if (head(v) >= 0) edges.push_back(pair<uint32_t, uint32_t>(v + 1, head(v) + 1));
+   }
+}
+
+undirected_graph dependency_tree::graph() const {
+   return undirected_graph(heads, n);
+}
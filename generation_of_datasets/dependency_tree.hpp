@@ -0,0 +1,90 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _DEPENDENCY_TREE_
+#define _DEPENDENCY_TREE_
+
+#include <cassert>
+#include <memory_resource>
+#include <vector>
+#include "common.hpp"
+#include "undirected_graph.hpp"
+
+using namespace std;
+
+/**
+ * A dependency tree seen through the heads of its vertices, as read from a
+ * .heads file (positions starting at 1, 0 for the root). It does not copy
+ * nor preprocess the heads, so building it costs nothing: the degrees, the
+ * children and the edges grouped by endpoint are computed only when asked
+ * for, and the undirected_graph only if it is really needed.
+ */
+class dependency_tree {
+private:
+   const int *heads;
+   int n;
+public:
+   // Pre: heads[v] is the position (starting at 1) of the head of v, or 0 if v is the root, 0 <= v < n,
+   //      and heads outlives the tree
+   dependency_tree(const int *heads, int n);
+   int vertices() const;
+   // Post: the head of v (starting at 0), -1 if v is the root
+   int head(int v) const;
+   // Post: the length of the edge between v and its head, 0 if v is the root
+   int edge_length(int v) const;
+   // the following ones take time linear in the number of vertices
+   int edges() const;
+   int edge_length_sum() const;
+   int sum_of_squared_degrees() const;
+   // the vectors keep their memory resource, which is also used for the temporary ones
+   void degrees(pmr::vector<int> &degree) const;
+   // Post: the children of v are child[first[v]], ..., child[first[v + 1] - 1], in increasing order
+   void children(pmr::vector<int> &first, pmr::vector<int> &child) const;
+   // Post: the right endpoints of the edges whose left (smaller) endpoint is i are
+   // right[first[i]], ..., right[first[i + 1] - 1]
+   void edges_by_left_endpoint(pmr::vector<int> &first, pmr::vector<int> &right) const;
+   // Post: the edges, with the vertices starting at 1, as taken by calculate_D_min_Shiloach
+   void edge_list(edge_vector &edges) const;
+   undirected_graph graph() const;
+};
+
+inline dependency_tree::dependency_tree(const int *heads, int n): heads(heads), n(n) {
+}
+
+inline int dependency_tree::vertices() const {
+   return n;
+}
+
+inline int dependency_tree::head(int v) const {
+   assert(0 <= v and v < n);
+   assert(heads[v] <= n and heads[v] != v + 1);
+   return heads[v] - 1;
+}
+
+inline int dependency_tree::edge_length(int v) const {
+   int h = head(v);
+   if (h < 0) return 0;
+   return h > v ? h - v : v - h;
+}
+
+#endif
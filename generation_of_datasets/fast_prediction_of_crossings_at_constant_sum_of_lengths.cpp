@@ -34,16 +34,36 @@
 #include <iostream>
 #include "undirected_graph.hpp"
 #include "frequency_spectrum.hpp"
+#include "fast_prediction_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "thread_pool.hpp"
 
 const bool simple = false;
 const bool equivalence_classes = true;
 const double numerical_error = 1e-8;
+// With more than one thread, the enumeration is split in tasks that place the
+// vertices after a prefix; there are at least this number of prefixes per thread
+const int prefixes_per_thread = 16;
+
+// The arguments of i_crossings_brute_force that change along the enumeration,
+// once the vertices before start have been placed
+struct partial_arrangement {
+   permutation p;
+   int start;
+   int edges;
+   int sum_of_lengths;
+   int crossings;
+   vector<int> remaining_degree;
+   int double_sum_of_lengths_of_remaining_edges_lower;
+   int double_sum_of_lengths_of_remaining_edges_upper;
+};
  
 double crossings_at_constant_sum_of_lengths_naive(const undirected_graph &g, int target_sum_of_lengths, vector<int> &father);
 undirected_graph rearrange_vertices_in_depth_first_order(const undirected_graph &g, int start,  vector<int> &father);
 void depth_first_order(const undirected_graph &g, int start, permutation &p, vector<bool> &visited, int & nvisited, vector<int> &father);
 void get_sum_of_lengths_max(int n, vector<int> &sum_of_lengths_max);
-void i_crossings_brute_force(const undirected_graph &g, const vector<int> &predecessor, int equivalent_permutations, const vector<int> &sum_of_lengths_max, const vector<int> &father, int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_lengths, vector<int> &remaining_degree, int &double_sum_of_lengths_of_remaining_edges_lower, int &double_sum_of_lengths_of_remaining_edges_upper, frequency_spectrum &crossings_statistics);
+void i_crossings_brute_force(const undirected_graph &g, const vector<int> &predecessor, int equivalent_permutations, const vector<int> &sum_of_lengths_max, const vector<int> &father, int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_lengths, int crossings, vector<int> &remaining_degree, int &double_sum_of_lengths_of_remaining_edges_lower, int &double_sum_of_lengths_of_remaining_edges_upper, frequency_spectrum &crossings_statistics, int split_depth = -1, vector<partial_arrangement> *prefixes = NULL);
+int crossings_of_new_edge(const permutation &p, const vector<int> &father, int start);
+int get_split_depth(int n, int threads);
 int get_equivalent_permutations(const undirected_graph &g, vector<int> &predecessor);
 double maximum_number_of_crossings(const undirected_graph &g);
 double factorial(int n);
@@ -71,7 +91,7 @@ void depth_first_order(const undirected_graph &g, int start, permutation &p, vec
       visited[start] = true;
       p[start] = nvisited;
       ++nvisited;
-      for (set<int>::const_iterator j = g.adjacent[start].begin(); j != g.adjacent[start].end(); ++j) {
+      for (neighbourhood::const_iterator j = g.adjacent[start].begin(); j != g.adjacent[start].end(); ++j) {
           bool ok = not visited[*j];
           depth_first_order(g, *j, p, visited, nvisited, father);
           if (ok) father[p[*j]] = p[start];  
@@ -129,7 +149,26 @@ double crossings_at_constant_sum_of_lengths_naive(const undirected_graph &g, int
        double_sum_of_lengths_of_remaining_edges_lower += minimum_linear_arrangement_of_star_tree(k); 
        double_sum_of_lengths_of_remaining_edges_upper += maximum_linear_arrangement_of_star_tree(g.vertices(), k); 
    }
-   i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, 0, p, 0, 0, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper, crossings_statistics);  
+   thread_pool *pool = default_thread_pool();
+   int split_depth = pool == NULL ? -1 : get_split_depth(g.vertices(), pool->threads());
+   if (split_depth < 0) {
+      i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, 0, p, 0, 0, 0, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper, crossings_statistics);  
+   }
+   else {
+      // the prefixes that the bounds on the sum of lengths do not rule out, each one completed by a task
+      vector<partial_arrangement> prefixes;
+      i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, 0, p, 0, 0, 0, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper, crossings_statistics, split_depth, &prefixes);
+      vector<frequency_spectrum> prefix_statistics(prefixes.size(), frequency_spectrum(ceil(crossings_max)));
+      task_group group(pool);
+      for (size_t t = 0; t < prefixes.size(); ++t) {
+          group.run([&, t]() {
+             partial_arrangement &a = prefixes[t];
+             i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, a.start, a.p, a.edges, a.sum_of_lengths, a.crossings, a.remaining_degree, a.double_sum_of_lengths_of_remaining_edges_lower, a.double_sum_of_lengths_of_remaining_edges_upper, prefix_statistics[t]);
+          });
+      }
+      group.wait();
+      for (size_t t = 0; t < prefixes.size(); ++t) crossings_statistics.merge(prefix_statistics[t]);
+   }
    assert(crossings_statistics.samples() > 0);
    assert(log(crossings_statistics.samples())+log(equivalent_permutations)>= log(2) - numerical_error); // there are at least two possible linear arrangements keeping the same sum of edge lengths: the original arrangement and its reverse
 //   assert(int(crossings_statistics.samples()) % 2 == 0 or equivalent_permutations % 2 == 0);
@@ -143,7 +182,7 @@ double crossings_at_constant_sum_of_lengths_naive(const undirected_graph &g, int
 }
 
 void i_crossings_brute_force(const undirected_graph &g, const vector<int> &predecessor, int equivalent_permutations, const vector<int> &sum_of_lengths_max, const vector<int> &father,
-int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_lengths, vector<int> &remaining_degree, int &double_sum_of_lengths_of_remaining_edges_lower, int &double_sum_of_lengths_of_remaining_edges_upper, frequency_spectrum &crossings_statistics) {
+int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_lengths, int crossings, vector<int> &remaining_degree, int &double_sum_of_lengths_of_remaining_edges_lower, int &double_sum_of_lengths_of_remaining_edges_upper, frequency_spectrum &crossings_statistics, int split_depth, vector<partial_arrangement> *prefixes) {
    // Pre: the edge (u,v) is visited iff u < start and v < start;
    //      if predecessor[v] != -1 then v is a leaf and predecessor[v] indicates the previous leaf attacched to the same vertex than v;
    //      equivalent_permutatons indicates the number of permutations such that they only differ in the relative ordering of the leafs attached to the same node;
@@ -151,7 +190,9 @@ int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_leng
    //      p[v] = the new position of vertex v for v = 0,1,...start - 1;    
    //      edges is the number of edges of g that have already been visited;
    //      sum_of_lengths is the sum of the lengths of the visited edges;     
+   //      crossings is the number of crossings among the visited edges;
    //      crossings_statistics = CS 
+   //      if prefixes != NULL, the arrangements are not completed beyond split_depth vertices but added to prefixes
    assert(1 <= equivalent_permutations);
    int n = g.vertices();
    assert(start <= n);
@@ -159,21 +200,28 @@ int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_leng
    assert(edges <= n - 1);
    assert(edges <= sum_of_lengths);
    assert(edges < start or start == 0);  
-   if (start == n) { 
+   assert(0 <= crossings);
+   if (prefixes != NULL and start == split_depth) {
+      partial_arrangement a = {p, start, edges, sum_of_lengths, crossings, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper};
+      prefixes->push_back(a);
+   }
+   else if (start == n) { 
       if (not simple) {
          for (int i = 0; i < n; ++i) {
              assert(remaining_degree[i] == 0);
          }
       }  
       assert(edges == n - 1);
+#ifdef CHECK_CROSSINGS
       undirected_graph h = scrambled_graph(g, p);
       assert(h.tree());
       assert(h.edges() == n - 1);
       assert(sum_of_lengths == h.edge_length_sum()); 
+      assert(crossings == h.crossings());
+#endif
       if (target_sum_of_lengths == sum_of_lengths) {
-         int C = h.crossings();
-         // cout << "      Crossings: " << C << endl;
-         crossings_statistics.insert(C);
+         // cout << "      Crossings: " << crossings << endl;
+         crossings_statistics.insert(crossings);
       }
    }
    else {
@@ -198,10 +246,12 @@ int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_leng
                 swap(p[start], p[i]);
                 int new_edges;
                 int new_lengths;
+                int new_crossings = 0;
                 if (start > 0) {
+                   new_crossings = crossings_of_new_edge(p, father, start);
                    if (simple) {
                       new_edges = new_lengths = 0; 
-                      for (set<int>::const_iterator j = g.adjacent[start].begin(); j != g.adjacent[start].end() and *j < start; ++j) {
+                      for (neighbourhood::const_iterator j = g.adjacent[start].begin(); j != g.adjacent[start].end() and *j < start; ++j) {
                           ++new_edges;
                           int length = abs(p[start] - p[*j]);
                           assert(father[start] == *j);
@@ -233,7 +283,7 @@ int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_leng
                 else {
                    new_edges = new_lengths = 0;
                 }
-                i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, start + 1, p, edges + new_edges, sum_of_lengths + new_lengths, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper, crossings_statistics);
+                i_crossings_brute_force(g, predecessor, equivalent_permutations, sum_of_lengths_max, father, target_sum_of_lengths, start + 1, p, edges + new_edges, sum_of_lengths + new_lengths, crossings + new_crossings, remaining_degree, double_sum_of_lengths_of_remaining_edges_lower, double_sum_of_lengths_of_remaining_edges_upper, crossings_statistics, split_depth, prefixes);
                 swap(p[start], p[i]);   
                 if (start > 0 and not simple) {
                    double_sum_of_lengths_of_remaining_edges_lower -= minimum_linear_arrangement_of_star_tree(remaining_degree[start]); 
@@ -257,6 +307,32 @@ int target_sum_of_lengths, int start, permutation &p, int edges, int sum_of_leng
    // 
 }
 
+inline int crossings_of_new_edge(const permutation &p, const vector<int> &father, int start) {
+   // Pre: 0 < start; p[v] is the position of v and father[v] < v for 0 < v <= start
+   int a = min(p[start], p[father[start]]);
+   int b = max(p[start], p[father[start]]);
+   int crossings = 0;
+   for (int v = 1; v < start; ++v) {
+       int c = min(p[v], p[father[v]]);
+       int d = max(p[v], p[father[v]]);
+       if ((a < c and c < b and b < d) or (c < a and a < d and d < b)) ++crossings;
+   }
+   return crossings;
+   // Post: the number of edges (v, father[v]), 0 < v < start, that cross the edge (start, father[start])
+}
+
+inline int get_split_depth(int n, int threads) {
+   // Pre: threads >= 1
+   double prefixes = 1;
+   for (int depth = 1; depth < n - 1; ++depth) {
+       prefixes *= n - depth + 1;
+       if (prefixes >= prefixes_per_thread*threads) return depth;
+   }
+   return -1;
+   // Post: the smallest number of vertices such that there are at least prefixes_per_thread*threads
+   //       ways of placing them, -1 if the arrangements are too few to be worth splitting
+}
+
 inline int get_equivalent_permutations(const undirected_graph &g, vector<int> &predecessor) { 
    int equivalent_permutations = 1;
    fill(predecessor.begin(), predecessor.end(), -1);
@@ -264,7 +340,7 @@ inline int get_equivalent_permutations(const undirected_graph &g, vector<int> &p
        if (g.adjacent[i].size() >= 2) {
           int leaves = 0;
           int last_leaf = -1;
-          for (set<int>::const_iterator j = g.adjacent[i].begin(); j != g.adjacent[i].end(); ++j) {
+          for (neighbourhood::const_iterator j = g.adjacent[i].begin(); j != g.adjacent[i].end(); ++j) {
               bool leaf = g.adjacent[*j].size() == 1;
               if (leaf) { 
                  ++leaves;
@@ -283,9 +359,9 @@ inline int get_equivalent_permutations(const undirected_graph &g, vector<int> &p
 }
 
 inline double maximum_number_of_crossings(const undirected_graph &g) {
+   // n*(n - 1 - <k^2>)/2, from the integer sum of squared degrees so that it is exact
    int n = g.vertices();
-   double degree_2nd_moment = g.degree_2nd_moment();
-   double crossings_max = n*(n - 1 - degree_2nd_moment)/double(2);
+   double crossings_max = (n*(n - 1) - g.sum_of_squared_degrees())/double(2);
    return crossings_max;
 }
 
@@ -32,7 +32,7 @@
 #include <cassert>
 #include "frequency_spectrum.hpp"
 
-frequency_spectrum::frequency_spectrum(int x_max): vector<int>(x_max + 1, 0) { 
+frequency_spectrum::frequency_spectrum(int x_max): vector<long long>(x_max + 1, 0) { 
    n = 0;
 }
 
@@ -43,17 +43,58 @@ void frequency_spectrum::insert(int x) {
    ++n;
 } 
 
+void frequency_spectrum::insert(int x, long long times) {
+   assert(0 <= x);
+   assert(x <= int(size()) - 1);    
+   assert(0 <= times);
+   (*this)[x] += times;
+   n += times;
+} 
+
+void frequency_spectrum::merge(const frequency_spectrum &s) {
+   assert(s.size() <= size());
+   for (int x = 0; x < int(s.size()); ++x) {
+       (*this)[x] += s[x];
+   }
+   n += s.n;
+}
+
 double frequency_spectrum::mean() const {
-   // the calculation of the mean is designed to minimize the risk of overflow
-   double m = 0;
+   // the calculation of the mean is designed to minimize the risk of overflow:
+   // the sum is exact in a long double below 2^64 and cannot overflow, and dividing
+   // once keeps the mean between the smallest and the largest value
+   long double sum = 0;
    for (int x = 1; x < int(size()); ++x) {
-       m += ((*this)[x]/n)*x; 
+       sum += (long double)((*this)[x])*x; 
    }
+   double m = sum/n;
    assert(m >= 0);
    assert(m <= int(size()) - 1);
    return m;   
 } 
 
+double frequency_spectrum::variance() const {
+   // about the mean, to avoid the cancellation of the sum of squares
+   double m = mean();
+   double v = 0;
+   for (int x = 0; x < int(size()); ++x) {
+       v += ((*this)[x]/n)*(x - m)*(x - m); 
+   }
+   assert(v >= 0);
+   return v;
+}
+
+int frequency_spectrum::quantile(double q) const {
+   assert(0 <= q and q <= 1);
+   assert(n > 0);
+   double below = 0;
+   for (int x = 0; x < int(size()); ++x) {
+       below += (*this)[x];
+       if (below >= q*n) return x;
+   }
+   return int(size()) - 1;
+}
+
 double frequency_spectrum::samples() const {
    return n;
 }
@@ -36,13 +36,20 @@
 
 using namespace std;
 
-class frequency_spectrum: vector<int> {
+class frequency_spectrum: vector<long long> {
    double n;
    public: 
       frequency_spectrum(int x_max);
       void insert(int x);
+      void insert(int x, long long times);
+      // Pre: the values of s are between 0 and the x_max of this spectrum
+      void merge(const frequency_spectrum &s);
       double samples() const;
       double mean() const;
+      double variance() const;
+      // Pre: 0 <= q <= 1 and samples() > 0
+      // Post: the smallest x such that a fraction of at least q of the samples are at most x
+      int quantile(double q) const;
 };
 
 #endif
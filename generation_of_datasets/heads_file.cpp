@@ -0,0 +1,90 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <charconv>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "heads_file.hpp"
+
+heads_file::heads_file(const char *file_name) : fd(-1), data(NULL), length(0), next(NULL) {
+   fd = open(file_name, O_RDONLY);
+   if (fd < 0) return;
+   struct stat info;
+   if (fstat(fd, &info) == 0 and info.st_size > 0) {
+      void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+         close(fd);
+         fd = -1;
+         return;
+      }
+      data = static_cast<const char *>(p);
+      length = info.st_size;
+      madvise(p, length, MADV_SEQUENTIAL);
+   }
+   next = data;
+}
+
+heads_file::~heads_file() {
+   if (data != NULL) munmap(const_cast<char *>(data), length);
+   if (fd >= 0) close(fd);
+}
+
+bool heads_file::good() const {
+   return fd >= 0;
+}
+
+bool heads_file::read_tree(vector<int> &heads) {
+   const char *end = data + length;
+   if (next == NULL or next == end) return false;
+   const char *p = next;
+   bool integers = true;
+   while (p != end and *p != '\n') {
+      if (*p == ' ' or *p == '\t' or *p == '\r' or *p == '\v' or *p == '\f') ++p;
+      else if (integers) {
+         // from_chars does not take the sign '+' that operator>> accepts
+         const char *digits = (*p == '+' and p + 1 != end and *(p + 1) != '-') ? p + 1 : p;
+         int head;
+         from_chars_result r = from_chars(digits, end, head);
+         if (r.ec == errc()) {
+            heads.push_back(head);
+            p = r.ptr;
+         }
+         else integers = false;
+      }
+      else ++p;
+   }
+   next = (p == end) ? end : p + 1;
+   return true;
+}
+
+heads_source::~heads_source() {
+}
+
+void heads_source::read_trees(vector<int> &heads, vector<size_t> &offset) {
+   assert(offset.empty() or offset.back() == heads.size());
+   if (offset.empty()) offset.push_back(heads.size());
+   while (read_tree(heads)) offset.push_back(heads.size());
+}
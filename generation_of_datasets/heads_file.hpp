@@ -0,0 +1,74 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _HEADS_FILE_
+#define _HEADS_FILE_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Trees given by the heads of their vertices (positions starting at 1, 0 for
+ * the root), read one after the other.
+ */
+class heads_source {
+public:
+   virtual ~heads_source();
+   // Post: false if the trees could not be opened
+   virtual bool good() const = 0;
+   // Post: the heads of the next tree have been appended to heads,
+   // false if there were no trees left
+   virtual bool read_tree(vector<int> &heads) = 0;
+   // Pre: offset is empty or ends at heads.size()
+   // Post: the heads of the remaining trees have been appended to heads.
+   // The heads of every new tree t are heads[offset[t]], ..., heads[offset[t+1]-1]
+   virtual void read_trees(vector<int> &heads, vector<size_t> &offset);
+};
+
+/**
+ * A .heads file mapped in memory. Every line is a tree given by the heads
+ * of its vertices (positions starting at 1, 0 for the root) separated by
+ * blanks. As when reading the line with an istream_iterator<int>, the tree
+ * ends at the first token of the line that is not an integer.
+ */
+class heads_file : public heads_source {
+private:
+   int fd;
+   const char *data;
+   size_t length;
+   const char *next; // beginning of the first line not read yet
+   heads_file(const heads_file &);
+   heads_file &operator=(const heads_file &);
+public:
+   heads_file(const char *file_name);
+   ~heads_file();
+   // Post: false if the file could not be opened
+   bool good() const;
+   // Post: the heads of the next line have been appended to heads,
+   // false if there were no lines left
+   bool read_tree(vector<int> &heads);
+};
+
+#endif
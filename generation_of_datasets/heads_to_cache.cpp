@@ -0,0 +1,60 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+// Converts .heads files to the binary treebank caches that analyze_treebanks
+// reads with --cache: every file is written to the same name followed by .cache.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "heads_file.hpp"
+#include "treebank_cache.hpp"
+
+using namespace std;
+
+int main( int argc , char * argv[] )
+{
+  if ( argc < 2 )
+  {
+    cerr << "Usage: " << argv[0] << " <heads file> ..." << endl;
+    return 1;
+  }
+  int problems = 0;
+  for ( int i = 1 ; i < argc ; i++ )
+  {
+    heads_file text(argv[i]);
+    std::string cache_file_name = std::string(argv[i]) + ".cache";
+    std::vector<int> heads;
+    std::vector<size_t> offset;
+    if ( text.good() )
+      text.read_trees( heads , offset );
+    if ( !text.good() || !write_treebank_cache( cache_file_name.c_str() , treebank_id(argv[i]) , heads , offset ) )
+    {
+      cerr << "Problem with " << argv[i] << endl;
+      problems++;
+      continue;
+    }
+    cout << argv[i] << ": " << offset.size() - 1 << " trees written to " << cache_file_name << endl;
+  }
+  return problems > 0 ? 1 : 0;
+}
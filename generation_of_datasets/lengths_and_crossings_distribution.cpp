@@ -0,0 +1,214 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include "lengths_and_crossings_distribution.hpp"
+
+// The vertices that have been placed and still have neighbours to place, in
+// the order they were placed. A token is either a vertex w < max_vertices, or
+// leaf_token + p for a leaf of p (only for the leaves of vertices that are not leaves).
+static const int leaf_token = 32;
+
+// A partial arrangement: the mask of the placed vertices (4 bytes) followed by the tokens
+typedef string frontier_state;
+// Number of partial arrangements with every (D, C) so far, as (D << 16 | C, count), by key
+typedef vector<pair<uint32_t, uint64_t> > partial_counts;
+
+// Post: a lower bound of what the vertices not in placed add to the sum of edge lengths
+static int minimum_growth(const vector<vector<int> > &neighbours, uint32_t placed) {
+   // The edges that leave placed span the gaps up to their other endpoint: at best, the vertices
+   // they go to come next, those with more of them first. Every other edge spans at least one gap,
+   // and the edges of every vertex at least as many as in a minimum linear arrangement of a star.
+   int n = neighbours.size();
+   int open[32];
+   int vertices = 0;
+   int growth = 0;
+   int edges = 0;
+   int star_lengths = 0;
+   for (int x = 0; x < n; ++x) {
+      if (placed >> x & 1) continue;
+      int from_placed = 0;
+      for (size_t k = 0; k < neighbours[x].size(); ++k) from_placed += placed >> neighbours[x][k] & 1;
+      if (from_placed > 0) open[vertices++] = from_placed;
+      int k = neighbours[x].size() - from_placed;
+      edges += k;
+      star_lengths += k % 2 == 0 ? (k/2)*(k/2 + 1) : ((k + 1)/2)*((k + 1)/2);
+   }
+   sort(open, open + vertices, greater<int>());
+   for (int i = 0; i < vertices; ++i) growth += open[i]*(i + 1);
+   // every edge between two vertices not placed has been counted twice
+   return growth + max(edges/2, (star_lengths + 1)/2);
+}
+
+// Post: the entries with the same (D, C) are added together and sorted by (D, C)
+static void compact(partial_counts &c) {
+   sort(c.begin(), c.end());
+   size_t k = 0;
+   for (size_t i = 0; i < c.size(); ++i) {
+      if (k > 0 and c[k - 1].first == c[i].first) c[k - 1].second += c[i].second;
+      else c[k++] = c[i];
+   }
+   c.resize(k);
+}
+
+lengths_and_crossings_distribution::lengths_and_crossings_distribution(const undirected_graph &g, int D): n(g.vertices()) {
+   assert(g.tree());
+   assert(n <= max_vertices);
+   D_max = max(0, (n - 1)*(n - 1)); // no edge is longer than n - 1
+   C_max = max(0, (n - 1)*(n - 2)/2);
+   arrangements = vector<vector<uint64_t> >(D_max + 1, vector<uint64_t>(C_max + 1, 0));
+   if (n == 0) return;
+   // The leaves of every vertex p that is not a leaf are placed in a fixed order,
+   // the k-th of them always before the (k+1)-th, and every choice of the next one
+   // counts as many times as leaves of p remain.
+   vector<int> parent(n, -1); // parent of the leaves that are put together
+   vector<vector<int> > leaves(n);
+   vector<vector<int> > neighbours(n);
+   for (int v = 0; v < n; ++v) {
+      neighbours[v] = vector<int>(g.adjacent[v].begin(), g.adjacent[v].end());
+   }
+   for (int v = 0; v < n; ++v) {
+      if (neighbours[v].size() == 1 and neighbours[neighbours[v][0]].size() > 1) {
+         parent[v] = neighbours[v][0];
+         leaves[parent[v]].push_back(v);
+      }
+   }
+   unordered_map<frontier_state, partial_counts> current, next;
+   current[frontier_state(4, '\0')].push_back(pair<uint32_t, uint64_t>(0, 1));
+   for (int placed = 0; placed < n; ++placed) {
+      next.clear();
+      for (unordered_map<frontier_state, partial_counts>::const_iterator it = current.begin(); it != current.end(); ++it) {
+         const frontier_state &s = it->first;
+         uint32_t mask = uint32_t((unsigned char)s[0]) | uint32_t((unsigned char)s[1]) << 8 | uint32_t((unsigned char)s[2]) << 16 | uint32_t((unsigned char)s[3]) << 24;
+         // the edges of every token that have not been closed yet
+         int tokens = s.size() - 4;
+         vector<int> open(tokens);
+         for (int t = 0; t < tokens; ++t) {
+            int token = (unsigned char)s[4 + t];
+            if (token >= leaf_token) open[t] = 1;
+            else {
+               open[t] = 0;
+               for (size_t k = 0; k < neighbours[token].size(); ++k) open[t] += not (mask >> neighbours[token][k] & 1);
+            }
+         }
+         for (int v = 0; v < n; ++v) {
+            if (mask >> v & 1) continue;
+            uint64_t times = 1;
+            if (parent[v] >= 0) {
+               // only the first leaf of its parent that has not been placed
+               const vector<int> &l = leaves[parent[v]];
+               int first = 0;
+               while (mask >> l[first] & 1) ++first;
+               if (l[first] != v) continue;
+               times = l.size() - first;
+            }
+            uint32_t new_mask = mask | uint32_t(1) << v;
+            // The edges closed by v are crossed by the edges still open whose left endpoint
+            // comes after theirs, except the ones that v closes too.
+            int new_crossings = 0;
+            int after = 0;
+            frontier_state t_next(4, '\0');
+            for (int b = 0; b < 4; ++b) t_next[b] = char(new_mask >> (8*b) & 255);
+            vector<char> closes(tokens);
+            for (int t = tokens - 1; t >= 0; --t) {
+               int token = (unsigned char)s[4 + t];
+               if (token >= leaf_token) closes[t] = token - leaf_token == v;
+               else closes[t] = find(neighbours[token].begin(), neighbours[token].end(), v) != neighbours[token].end();
+               if (closes[t]) new_crossings += after;
+               after += open[t] - closes[t];
+            }
+            int cut = 0;
+            for (int t = 0; t < tokens; ++t) {
+               if (open[t] - closes[t] > 0) {
+                  t_next.push_back(s[4 + t]);
+                  cut += open[t] - closes[t];
+               }
+            }
+            int v_open = 0;
+            for (size_t k = 0; k < neighbours[v].size(); ++k) v_open += not (new_mask >> neighbours[v][k] & 1);
+            if (v_open > 0) t_next.push_back(char(parent[v] >= 0 ? leaf_token + parent[v] : v));
+            cut += v_open;
+            // the gap after the last position is not spanned by any edge
+            assert(placed < n - 1 or cut == 0);
+            int growth = D >= 0 ? minimum_growth(neighbours, new_mask) : 0;
+            uint32_t shift = uint32_t(cut) << 16 | uint32_t(new_crossings);
+            // the partial counts are sorted by the sum of lengths so far
+            uint32_t too_long = uint32_t(D - growth + 1) << 16;
+            partial_counts *c = NULL;
+            for (size_t k = 0; k < it->second.size(); ++k) {
+               if (D >= 0 and (D < growth or it->second[k].first >= too_long)) break;
+               if (c == NULL) c = &next[t_next];
+               c->push_back(pair<uint32_t, uint64_t>(it->second[k].first + shift, it->second[k].second*times));
+            }
+         }
+      }
+      for (unordered_map<frontier_state, partial_counts>::iterator it = next.begin(); it != next.end(); ++it) compact(it->second);
+      swap(current, next);
+   }
+   assert(current.size() == 1 or (D >= 0 and current.empty()));
+   if (current.empty()) return;
+   const partial_counts &c = current.begin()->second;
+   for (size_t k = 0; k < c.size(); ++k) {
+      int length = c[k].first >> 16;
+      int crossings = c[k].first & 65535;
+      assert(length <= D_max and crossings <= C_max);
+      // the bound only rules out the arrangements that are too long
+      if (D < 0 or length == D) arrangements[length][crossings] += c[k].second;
+   }
+}
+
+int lengths_and_crossings_distribution::vertices() const {
+   return n;
+}
+
+uint64_t lengths_and_crossings_distribution::count(int D, int C) const {
+   if (D < 0 or D > D_max or C < 0 or C > C_max) return 0;
+   return arrangements[D][C];
+}
+
+frequency_spectrum lengths_and_crossings_distribution::crossings_given_sum_of_lengths(int D) const {
+   frequency_spectrum s(C_max);
+   if (D < 0 or D > D_max) return s;
+   for (int C = 0; C <= C_max; ++C) s.insert(C, arrangements[D][C]);
+   return s;
+}
+
+frequency_spectrum lengths_and_crossings_distribution::crossings() const {
+   frequency_spectrum s(C_max);
+   for (int D = 0; D <= D_max; ++D) {
+      for (int C = 0; C <= C_max; ++C) s.insert(C, arrangements[D][C]);
+   }
+   return s;
+}
+
+frequency_spectrum lengths_and_crossings_distribution::sum_of_lengths() const {
+   frequency_spectrum s(D_max);
+   for (int D = 0; D <= D_max; ++D) {
+      for (int C = 0; C <= C_max; ++C) s.insert(D, arrangements[D][C]);
+   }
+   return s;
+}
@@ -0,0 +1,72 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _LENGTHS_AND_CROSSINGS_DISTRIBUTION_
+#define _LENGTHS_AND_CROSSINGS_DISTRIBUTION_
+
+#include <cstdint>
+#include <vector>
+#include "frequency_spectrum.hpp"
+#include "undirected_graph.hpp"
+
+using namespace std;
+
+/**
+ * Exact joint distribution of the sum of edge lengths D and the number of
+ * crossings C over the n! linear arrangements of a tree, by dynamic
+ * programming on the arrangements built from left to right.
+ *
+ * D is the sum, over the n - 1 gaps between consecutive positions, of the
+ * edges that span the gap, and an edge (u, v), u placed before v, is crossed
+ * by the edges whose left endpoint comes after u and whose right endpoint
+ * comes after v. So, once some vertices have been placed, what the others add
+ * to D and C depends only on which vertices have been placed and on the order
+ * of those that still have neighbours to place. The arrangements with the
+ * same such state are counted together. The leaves of the same vertex cannot
+ * be told apart, so the state only keeps how many of them have been placed.
+ */
+class lengths_and_crossings_distribution {
+private:
+   int n;
+   int D_max;
+   int C_max;
+   vector<vector<uint64_t> > arrangements; // arrangements[D][C]
+public:
+   // Beyond this number of vertices the number of arrangements does not fit in 64 bits
+   static const int max_vertices = 20;
+   // Pre: g is a tree of at most max_vertices vertices
+   // Post: if D >= 0, only the arrangements whose sum of edge lengths is D are counted,
+   //       which takes much less time and memory when D is small, as in the treebanks
+   lengths_and_crossings_distribution(const undirected_graph &g, int D = -1);
+   int vertices() const;
+   // Post: the number of arrangements with sum of edge lengths D and C crossings
+   uint64_t count(int D, int C) const;
+   // Post: the distribution of C over the arrangements whose sum of edge lengths is D
+   frequency_spectrum crossings_given_sum_of_lengths(int D) const;
+   // Post: the distribution of C over all the arrangements
+   frequency_spectrum crossings() const;
+   // Post: the distribution of D over all the arrangements
+   frequency_spectrum sum_of_lengths() const;
+};
+
+#endif
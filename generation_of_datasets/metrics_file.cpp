@@ -0,0 +1,217 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "metrics_file.hpp"
+
+static const char metrics_magic[8] = { 'O', 'S', 'D', 'D', 'C', 'O', 'L', 'S' };
+static const uint32_t metrics_version = 1;
+
+// bytes of a value of the column with bit c
+static size_t column_width(int c) {
+   if ((1 << c) == column_Omega) return 8;
+   if ((1 << c) == column_language) return 2;
+   return 4;
+}
+
+static size_t padded(size_t bytes) {
+   return (bytes + 7)/8*8;
+}
+
+metrics_table::metrics_table(unsigned columns): columns(columns) {
+}
+
+size_t metrics_table::rows() const {
+   if (columns & column_n) return n.size();
+   if (columns & column_K2) return K2.size();
+   if (columns & column_D) return D.size();
+   if (columns & column_D_min) return D_min.size();
+   if (columns & column_C) return C.size();
+   if (columns & column_Omega) return Omega.size();
+   return language.size();
+}
+
+uint16_t metrics_table::language_id(const string &code) {
+   for (size_t i = 0; i < languages.size(); ++i) {
+      if (languages[i] == code) return i;
+   }
+   assert(languages.size() < 65536);
+   languages.push_back(code);
+   return languages.size() - 1;
+}
+
+void metrics_table::append(const tree_metrics &m, uint16_t l) {
+   if (columns & column_n) n.push_back(m.n);
+   if (columns & column_K2) K2.push_back(m.K2);
+   if (columns & column_D) D.push_back(m.D);
+   if (columns & column_D_min) D_min.push_back(m.D_min);
+   if (columns & column_C) C.push_back(m.C);
+   if (columns & column_Omega) Omega.push_back(m.Omega);
+   if (columns & column_language) language.push_back(l);
+   else assert(l == 0);
+}
+
+void metrics_table::append(const metrics_table &t) {
+   assert(columns == t.columns);
+   n.insert(n.end(), t.n.begin(), t.n.end());
+   K2.insert(K2.end(), t.K2.begin(), t.K2.end());
+   D.insert(D.end(), t.D.begin(), t.D.end());
+   D_min.insert(D_min.end(), t.D_min.begin(), t.D_min.end());
+   C.insert(C.end(), t.C.begin(), t.C.end());
+   Omega.insert(Omega.end(), t.Omega.begin(), t.Omega.end());
+   vector<uint16_t> id(t.languages.size());
+   for (size_t i = 0; i < id.size(); ++i) id[i] = language_id(t.languages[i]);
+   for (size_t i = 0; i < t.language.size(); ++i) language.push_back(id[t.language[i]]);
+}
+
+// little-endian encoding, whatever the host
+static void put(vector<char> &out, uint64_t x, size_t bytes) {
+   for (size_t i = 0; i < bytes; ++i) out.push_back(char((x >> (8*i)) & 0xff));
+}
+
+template<class T> static void put_column(vector<char> &out, const vector<T> &v, size_t bytes) {
+   for (size_t i = 0; i < v.size(); ++i) {
+      uint64_t x;
+      if (sizeof(T) == 8) memcpy(&x, &v[i], 8);
+      else x = uint64_t(v[i]);
+      put(out, x, bytes);
+   }
+   out.resize(padded(out.size()), 0);
+}
+
+bool write_metrics_file(const char *file_name, const metrics_table &t) {
+   vector<char> out(metrics_magic, metrics_magic + 8);
+   put(out, metrics_version, 4);
+   put(out, t.columns, 4);
+   put(out, t.rows(), 8);
+   put(out, t.languages.size(), 4);
+   for (size_t i = 0; i < t.languages.size(); ++i) {
+      put(out, t.languages[i].size(), 4);
+      out.insert(out.end(), t.languages[i].begin(), t.languages[i].end());
+   }
+   out.resize(padded(out.size()), 0);
+   if (t.columns & column_n) put_column(out, t.n, 4);
+   if (t.columns & column_K2) put_column(out, t.K2, 4);
+   if (t.columns & column_D) put_column(out, t.D, 4);
+   if (t.columns & column_D_min) put_column(out, t.D_min, 4);
+   if (t.columns & column_C) put_column(out, t.C, 4);
+   if (t.columns & column_Omega) put_column(out, t.Omega, 8);
+   if (t.columns & column_language) put_column(out, t.language, 2);
+   ofstream file(file_name, ios::binary);
+   file.write(out.data(), out.size());
+   return bool(file);
+}
+
+metrics_file::metrics_file(const char *file_name) : fd(-1), data(NULL), length(0), columns(0), row_count(0) {
+   for (int c = 0; c < metrics_columns; ++c) column_data[c] = NULL;
+   assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+   fd = open(file_name, O_RDONLY);
+   if (fd < 0) return;
+   struct stat info;
+   void *p = MAP_FAILED;
+   if (fstat(fd, &info) == 0 and info.st_size >= 32) p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (p != MAP_FAILED) {
+      data = static_cast<const char *>(p);
+      length = info.st_size;
+   }
+   uint32_t version, languages;
+   uint64_t rows;
+   if (data == NULL or memcmp(data, metrics_magic, 8) != 0) goto bad;
+   memcpy(&version, data + 8, 4);
+   memcpy(&columns, data + 12, 4);
+   memcpy(&rows, data + 16, 8);
+   memcpy(&languages, data + 24, 4);
+   if (version != metrics_version) goto bad;
+   {
+      size_t position = 28;
+      for (uint32_t i = 0; i < languages; ++i) {
+         uint32_t code_length;
+         if (position + 4 > length) goto bad;
+         memcpy(&code_length, data + position, 4);
+         position += 4;
+         if (position + code_length > length) goto bad;
+         language_codes.push_back(string(data + position, code_length));
+         position += code_length;
+      }
+      position = padded(position);
+      for (int c = 0; c < metrics_columns; ++c) {
+         if (columns & (1u << c)) {
+            column_data[c] = data + position;
+            position += padded(rows*column_width(c));
+         }
+      }
+      if (position > length) goto bad;
+   }
+   row_count = rows;
+   return;
+bad:
+   if (data != NULL) munmap(const_cast<char *>(data), length);
+   close(fd);
+   fd = -1;
+   data = NULL;
+   columns = 0;
+}
+
+metrics_file::~metrics_file() {
+   if (data != NULL) munmap(const_cast<char *>(data), length);
+   if (fd >= 0) close(fd);
+}
+
+bool metrics_file::good() const {
+   return fd >= 0;
+}
+
+size_t metrics_file::rows() const {
+   return row_count;
+}
+
+bool metrics_file::has(metrics_column c) const {
+   return columns & c;
+}
+
+const vector<string> &metrics_file::languages() const {
+   return language_codes;
+}
+
+const uint32_t *metrics_file::integers(metrics_column c) const {
+   assert(has(c) and c != column_Omega and c != column_language);
+   int bit = 0;
+   while ((1 << bit) != c) ++bit;
+   return reinterpret_cast<const uint32_t *>(column_data[bit]);
+}
+
+const double *metrics_file::Omega() const {
+   assert(has(column_Omega));
+   return reinterpret_cast<const double *>(column_data[5]);
+}
+
+const uint16_t *metrics_file::language() const {
+   assert(has(column_language));
+   return reinterpret_cast<const uint16_t *>(column_data[6]);
+}
@@ -0,0 +1,111 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _METRICS_FILE_
+#define _METRICS_FILE_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tree_metrics.hpp"
+
+using namespace std;
+
+// Binary columnar files with the metrics of every tree, an alternative to the
+// .omegas files and the antidlm tables. All numbers are little-endian:
+//   "OSDDCOLS", version (uint32), columns (uint32, the metrics_column bits),
+//   rows (uint64), number of languages (uint32), and for each language the
+//   length (uint32) and the characters of its code;
+// then, padded to a multiple of 8 bytes, one column after the other in the
+// order of the bits, each of them padded to a multiple of 8 bytes too.
+// The integer columns are uint32, Omega is a double and the language is
+// a uint16 index into the codes of the header.
+enum metrics_column {
+   column_n = 1,
+   column_K2 = 2,
+   column_D = 4,
+   column_D_min = 8,
+   column_C = 16,
+   column_Omega = 32,
+   column_language = 64
+};
+
+const int metrics_columns = 7;
+
+/**
+ * The columns of a metrics file held in memory, filled one tree at a time.
+ */
+class metrics_table {
+public:
+   unsigned columns;
+   vector<string> languages;
+   vector<uint32_t> n, K2, D, D_min, C;
+   vector<double> Omega;
+   vector<uint16_t> language;
+   metrics_table(unsigned columns = 0);
+   size_t rows() const;
+   // Post: the id of the language with that code, added if it was not there
+   uint16_t language_id(const string &code);
+   // Pre: column_language is in columns if language != 0
+   void append(const tree_metrics &m, uint16_t language = 0);
+   // Pre: t has the same columns
+   // Post: the rows of t are after the current ones, with their language ids translated
+   void append(const metrics_table &t);
+};
+
+// Post: false if the file could not be written
+bool write_metrics_file(const char *file_name, const metrics_table &t);
+
+/**
+ * A metrics file mapped in memory: the columns are read in place, without
+ * parsing. Only for little-endian hosts.
+ */
+class metrics_file {
+private:
+   int fd;
+   const char *data;
+   size_t length;
+   unsigned columns;
+   size_t row_count;
+   vector<string> language_codes;
+   const char *column_data[metrics_columns];
+   metrics_file(const metrics_file &);
+   metrics_file &operator=(const metrics_file &);
+public:
+   metrics_file(const char *file_name);
+   ~metrics_file();
+   // Post: false if the file could not be opened or is not a metrics file
+   bool good() const;
+   size_t rows() const;
+   bool has(metrics_column c) const;
+   const vector<string> &languages() const;
+   // Pre: has(c), c is not column_Omega nor column_language
+   const uint32_t *integers(metrics_column c) const;
+   // Pre: has(column_Omega)
+   const double *Omega() const;
+   // Pre: has(column_language)
+   const uint16_t *language() const;
+};
+
+#endif
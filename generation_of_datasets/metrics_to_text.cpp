@@ -0,0 +1,94 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+// Converts a binary metrics file written by analyze_treebanks --binary back to
+// the text layout that analyze_treebanks writes without --binary:
+// - with crossings, the layout of the incremental path: n C D K2 Omega
+// - with Omega, the layout of the .omegas files: n D D_min D_random Omega
+// - otherwise, the antidlm table with its header: [language] n K2 D D_min
+
+#include <iostream>
+#include <fstream>
+#include "metrics_file.hpp"
+#include "buffered_writer.hpp"
+
+using namespace std;
+
+int main( int argc , char * argv[] )
+{
+  if ( argc < 2 || argc > 3 )
+  {
+    cerr << "Usage: " << argv[0] << " <binary metrics file> [<text file>]" << endl;
+    return 1;
+  }
+  metrics_file in(argv[1]);
+  if ( !in.good() )
+  {
+    cerr << "Problem with " << argv[1] << endl;
+    return 1;
+  }
+  ofstream file;
+  if ( argc == 3 ) file.open(argv[2]);
+  buffered_writer out( argc == 3 ? file : cout );
+
+  const uint32_t *n = in.integers(column_n);
+  if ( in.has(column_C) )
+  {
+    const uint32_t *C = in.integers(column_C);
+    const uint32_t *D = in.integers(column_D);
+    const uint32_t *K2 = in.integers(column_K2);
+    const double *Omega = in.Omega();
+    for ( size_t i = 0 ; i < in.rows() ; i++ )
+      out << int(n[i]) << ' ' << int(C[i]) << ' ' << int(D[i]) << ' ' << int(K2[i]) << ' ' << Omega[i] << '\n';
+  }
+  else if ( in.has(column_Omega) )
+  {
+    const uint32_t *D = in.integers(column_D);
+    const uint32_t *D_min = in.integers(column_D_min);
+    const double *Omega = in.Omega();
+    for ( size_t i = 0 ; i < in.rows() ; i++ )
+    {
+      int length = n[i];
+      double D_random = (length-1)*(length+1)/double(3);
+      out << length << ' ' << int(D[i]) << ' ' << int(D_min[i]) << ' ' << D_random << ' ' << Omega[i] << '\n';
+    }
+  }
+  else
+  {
+    const uint32_t *K2 = in.integers(column_K2);
+    const uint32_t *D = in.integers(column_D);
+    const uint32_t *D_min = in.integers(column_D_min);
+    const uint16_t *language = in.has(column_language) ? in.language() : NULL;
+    if ( language != NULL )
+      out << "language" << ' ';
+    out << "n" << ' ' << "K2" << ' ' << "D" << ' ' << "D_min" << ' ' << '\n';
+    for ( size_t i = 0 ; i < in.rows() ; i++ )
+    {
+      //as in the text tables, no column for an unknown language
+      if ( language != NULL && !in.languages()[language[i]].empty() )
+        out << in.languages()[language[i]] << ' ';
+      out << int(n[i]) << ' ' << int(K2[i]) << ' ' << int(D[i]) << ' ' << int(D_min[i]) << ' ' << '\n';
+    }
+  }
+  return 0;
+}
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include "permutation.hpp"
+#include "random_trees.hpp"
 
 permutation::permutation(int vertices): vector<int>(vertices) {
    for (int i = 0; i < vertices; ++i) {
@@ -39,6 +40,6 @@ permutation::permutation(int vertices): vector<int>(vertices) {
 }
 
 void permutation::scramble() {
-   random_shuffle(begin(),end());
+   shuffle(begin(),end(),random_generator());
 }
 
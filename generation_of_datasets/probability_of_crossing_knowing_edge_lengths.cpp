@@ -30,16 +30,36 @@
  ********************************************************************/
 
 #include <cassert>
+#include <cstdio>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
 #include "probability_of_crossing_knowing_edge_lengths.hpp"
 
+const char probability_tables_magic[] = "PCKEL-TABLES-1";
+
+static mutex cached_tables_mutex;
+static map<int, unique_ptr<const probability_of_crossing_knowing_edge_lengths> > cached_tables;
+
+int probability_of_crossing_knowing_edge_lengths::verification_bound = 0;
+
+void probability_of_crossing_knowing_edge_lengths::set_verification_bound(int vertices) {
+   verification_bound = vertices;
+}
+
 probability_of_crossing_knowing_edge_lengths::probability_of_crossing_knowing_edge_lengths() {
    n = 0;
 }
 
 probability_of_crossing_knowing_edge_lengths::probability_of_crossing_knowing_edge_lengths(int vertices) {
    n = vertices;
+   if (n <= verification_bound) check_enumeration();
+   if (n > max_tabulated_vertices) return;
    p_crossing = vector<vector<double> >(n + 1, vector<double>(n + 1, 0));
    for (int d1 = 1; d1 < n; ++d1) {
       for (int d2 = 1; d2 < n; ++d2) {
@@ -67,7 +87,61 @@ inline void probability_of_crossing_knowing_edge_lengths::check_symmetry() const
    }
 }
 
+void probability_of_crossing_knowing_edge_lengths::check_enumeration() const {
+   int mismatches = 0;
+   for (int d1 = 1; d1 < n; ++d1) {
+      for (int d2 = 1; d2 < n; ++d2) {
+          if (get_probability_of_crossing(d1, d2) != get_probability_of_crossing_by_enumeration(d1, d2)) {
+             cerr << "Probability of crossing for n = " << n << ", d1 = " << d1 << ", d2 = " << d2 << ": " << get_probability_of_crossing(d1, d2) << " but " << get_probability_of_crossing_by_enumeration(d1, d2) << " by enumeration" << endl;
+             ++mismatches;
+          }
+      }
+   }
+   assert(mismatches == 0);
+}
+
+inline long long interleaved_placements(int n, int d1, int d2) {
+   // Placements with start1 < start2 < end1 < end2. With t = start2 - start1 it must be 
+   // t < d1 (start2 < end1) and t > d1 - d2 (end1 < end2), and for every such t start1 can take
+   // the values 1, 2, ... n - d2 - t (end2 <= n).
+   long long lower = max(1, d1 - d2 + 1);
+   long long upper = min(d1 - 1, n - d2 - 1);
+   if (lower > upper) return 0;
+   long long values_of_t = upper - lower + 1;
+   return values_of_t*(n - d2) - (lower + upper)*values_of_t/2;
+}
+
 double probability_of_crossing_knowing_edge_lengths::get_probability_of_crossing(int d1, int d2) const {
+   assert(n>0);
+   assert(1 <= d1);
+   assert(d1 < n);
+   assert(1 <= d2);
+   assert(d2 < n);
+   // all the placements of the two edges, minus those where they share a vertex: start1 == start2, 
+   // end1 == end2 (the same placements when d1 == d2), end1 == start2 and end2 == start1
+   long long pairs = (long long)(n - d1)*(n - d2);
+   long long same_start = n - max(d1, d2);
+   pairs -= same_start;
+   if (d1 != d2) pairs -= same_start;
+   pairs -= 2*max(0, n - d1 - d2);
+   long long crossings = interleaved_placements(n, d1, d2) + interleaved_placements(n, d2, d1);
+   double p;
+   if (pairs == 0) {
+      p = 0;
+   }
+   else {
+      assert(pairs > 0);
+      p = crossings/double(pairs);
+   }
+   assert(0 <= p);
+   assert(p <= 1);
+   return p;
+   // Post: returns the probability that an edge of length d1 and another edge of length d2 cross in a sentence of length n 
+   //       knowing that the edges do not share any vertex, in constant time. 
+   //       The result is the same double as that of get_probability_of_crossing_by_enumeration
+}
+
+double probability_of_crossing_knowing_edge_lengths::get_probability_of_crossing_by_enumeration(int d1, int d2) const {
    assert(n>0);
    assert(1 <= d1);
    assert(d1 < n);
@@ -116,6 +190,7 @@ double probability_of_crossing_knowing_edge_lengths::probability_of_crossing(int
    assert(d1 <= n - 1);
    assert(1 <= d2);
    assert(d2 <= n - 1);
+   if (n > max_tabulated_vertices) return get_probability_of_crossing(d1, d2);
    return p_crossing[d1][d2];
 }
 
@@ -123,27 +198,124 @@ int probability_of_crossing_knowing_edge_lengths::vertices() const {
    return n;
 }
 
+bool probability_of_crossing_knowing_edge_lengths::tabulated() const {
+   return n <= max_tabulated_vertices;
+}
+
 void probability_of_crossing_knowing_edge_lengths::write(const char *file) const {
   ofstream out(file);
   for (int d1 = 1; d1 < n; ++d1) {
-      out << p_crossing[d1][1];
+      out << probability_of_crossing(d1, 1);
       for (int d2 = 2; d2 < n; ++d2) {
-          out << " " << p_crossing[d1][d2];
+          out << " " << probability_of_crossing(d1, d2);
           // Checking that the probability is symmetric
-          assert(p_crossing[d1][d2] == p_crossing[d2][d1]);
+          assert(probability_of_crossing(d1, d2) == probability_of_crossing(d2, d1));
       }
       out << endl;
   }
 }
 
+void probability_of_crossing_knowing_edge_lengths::save(ofstream &out) const {
+  assert(tabulated());
+  out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+  for (int d1 = 1; d1 < n; ++d1) {
+      out.write(reinterpret_cast<const char *>(&p_crossing[d1][1]), (n - 1)*sizeof(double));
+  }
+}
+
+bool probability_of_crossing_knowing_edge_lengths::load(ifstream &in) {
+  int vertices;
+  if (not in.read(reinterpret_cast<char *>(&vertices), sizeof(vertices)) or vertices < 0 or vertices > max_tabulated_vertices) return false;
+  n = vertices;
+  p_crossing = vector<vector<double> >(n + 1, vector<double>(n + 1, 0));
+  for (int d1 = 1; d1 < n; ++d1) {
+      if (not in.read(reinterpret_cast<char *>(&p_crossing[d1][1]), (n - 1)*sizeof(double))) return false;
+  }
+  check_symmetry();
+  return true;
+}
+
 void probability_of_crossing_knowing_edge_lengths::write_3D(const char *file) const {
   ofstream out(file);
   for (int d1 = 1; d1 < n; ++d1) {
       for (int d2 = 1; d2 < n; ++d2) {
-          out << d1 << " " << d2 << " " << p_crossing[d1][d2] << endl;
+          out << d1 << " " << d2 << " " << probability_of_crossing(d1, d2) << endl;
           // Checking that the probability is symmetric
-          assert(p_crossing[d1][d2] == p_crossing[d2][d1]);
+          assert(probability_of_crossing(d1, d2) == probability_of_crossing(d2, d1));
       }
   }
 }
 
+const probability_of_crossing_knowing_edge_lengths &probability_of_crossing_table(int vertices) {
+   {
+      lock_guard<mutex> lock(cached_tables_mutex);
+      map<int, unique_ptr<const probability_of_crossing_knowing_edge_lengths> >::const_iterator i = cached_tables.find(vertices);
+      if (i != cached_tables.end()) return *i->second;
+   }
+   // the table is built without holding the lock so that tables for other sizes can be built meanwhile;
+   // if another thread got there first its table is kept and this one is discarded
+   unique_ptr<const probability_of_crossing_knowing_edge_lengths> table(new probability_of_crossing_knowing_edge_lengths(vertices));
+   lock_guard<mutex> lock(cached_tables_mutex);
+   return *cached_tables.emplace(vertices, std::move(table)).first->second;
+}
+
+int cached_probability_of_crossing_tables() {
+   lock_guard<mutex> lock(cached_tables_mutex);
+   int tables = 0;
+   for (map<int, unique_ptr<const probability_of_crossing_knowing_edge_lengths> >::const_iterator i = cached_tables.begin(); i != cached_tables.end(); ++i) {
+      if (i->second->tabulated()) ++tables;
+   }
+   return tables;
+   // Post: returns the number of tables in the cache that write_probability_of_crossing_tables would save
+}
+
+int read_probability_of_crossing_tables(const char *file) {
+   ifstream in(file, ios::binary);
+   if (not in) return 0;
+   char magic[sizeof(probability_tables_magic)];
+   if (not in.read(magic, sizeof(magic)) or string(magic, sizeof(magic)) != string(probability_tables_magic, sizeof(magic))) {
+      cerr << "Not a file of probability of crossing tables: " << file << endl;
+      return 0;
+   }
+   int loaded = 0;
+   lock_guard<mutex> lock(cached_tables_mutex);
+   while (in.peek() != EOF) {
+      unique_ptr<probability_of_crossing_knowing_edge_lengths> table(new probability_of_crossing_knowing_edge_lengths());
+      if (not table->load(in)) {
+         cerr << "Truncated file of probability of crossing tables: " << file << endl;
+         break;
+      }
+      int vertices = table->vertices();
+      bool tabulated = table->tabulated();
+      if (cached_tables.emplace(vertices, std::move(table)).second and tabulated) ++loaded;
+   }
+   return loaded;
+   // Post: returns the number of tabulated tables added to the cache
+}
+
+void write_probability_of_crossing_tables(const char *file) {
+   // the tables are written to a temporary file of this process that is then renamed, so that an
+   // interrupted run, or another one writing the same file, never leaves it half-written
+   string temporary_file = string(file) + "." + to_string(getpid()) + ".tmp";
+   {
+   ofstream out(temporary_file.c_str(), ios::binary);
+   out.write(probability_tables_magic, sizeof(probability_tables_magic));
+   lock_guard<mutex> lock(cached_tables_mutex);
+   for (map<int, unique_ptr<const probability_of_crossing_knowing_edge_lengths> >::const_iterator i = cached_tables.begin(); i != cached_tables.end(); ++i) {
+       // tables that are not tabulated are computed as fast as they would be read
+       if (i->second->tabulated()) i->second->save(out);
+   }
+   out.close();
+   if (not out) {
+      cerr << "Could not write the probability of crossing tables to " << temporary_file << endl;
+      remove(temporary_file.c_str());
+      return;
+   }
+   }
+   if (rename(temporary_file.c_str(), file) != 0) {
+      cerr << "Could not replace " << file << " with " << temporary_file << endl;
+      remove(temporary_file.c_str());
+   }
+   // Post: file has all the tabulated tables in the cache, or is as it was and the failure has been
+   //       reported on cerr
+}
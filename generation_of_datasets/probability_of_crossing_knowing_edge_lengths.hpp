@@ -33,24 +33,44 @@
 #define _PROBABILITY_OF_CROSSING_KNOWING_EDGE_LENGTHS_
 
 #include <vector>
+#include <fstream>
 
 using namespace std;
 
 class probability_of_crossing_knowing_edge_lengths {
 private:
-   vector<vector<double> > p_crossing;
+   static int verification_bound;
+   vector<vector<double> > p_crossing; // empty if n > max_tabulated_vertices
    int n;
    double get_probability_of_crossing(int d1, int d2) const;
+   double get_probability_of_crossing_by_enumeration(int d1, int d2) const;
    void check_symmetry() const;
+   void check_enumeration() const;
 public:
+   // Beyond this number of vertices the probabilities are computed when asked for instead of tabulated
+   static const int max_tabulated_vertices = 256;
+   // Tables of at most this number of vertices are checked cell by cell against the enumeration of
+   // all the placements of the two edges (0, the default, disables the check)
+   static void set_verification_bound(int vertices);
    probability_of_crossing_knowing_edge_lengths();
    probability_of_crossing_knowing_edge_lengths(int vertices);
    double probability_of_crossing(int d1, int d2) const;
    bool edge_crossing(int start1, int end1, int start2, int end2) const;
    int vertices() const;
+   bool tabulated() const;
    void write(const char *file) const;
    void write_3D(const char *file) const;
+   void save(ofstream &out) const;
+   bool load(ifstream &in);
 };
 
+// Process-wide cache of tables: the table for a given number of vertices is built only once
+// and then shared, also among threads. The cache can be saved to and loaded from a binary file
+// (in the byte order of the machine that wrote it).
+const probability_of_crossing_knowing_edge_lengths &probability_of_crossing_table(int vertices);
+int cached_probability_of_crossing_tables();
+int read_probability_of_crossing_tables(const char *file);
+void write_probability_of_crossing_tables(const char *file);
+
 #endif
 
@@ -0,0 +1,102 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <atomic>
+#include <cassert>
+#include <memory_resource>
+#include "random_trees.hpp"
+#include "scratch_arena.hpp"
+
+static atomic<uint64_t> random_seed(1);
+static atomic<uint64_t> seeded_threads(0);
+
+// splitmix64: nearby seeds give unrelated generators
+static uint64_t mix(uint64_t x) {
+   x += 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+mt19937_64 &random_generator() {
+   static thread_local mt19937_64 g(mix(random_seed.load() + mix(seeded_threads++)));
+   return g;
+}
+
+void seed_random_generator(uint64_t seed) {
+   random_generator().seed(seed);
+}
+
+void set_random_seed(uint64_t seed) {
+   random_seed = seed;
+}
+
+void uniformly_random_tree(int n, int *heads, mt19937_64 &g) {
+   assert(n >= 1);
+   heads[n - 1] = 0;
+   if (n == 1) return;
+   scratch_scope scope;
+   // The leaf removed at every step of the decoding hangs from the vertex of the
+   // sequence, which is its head in the tree rooted at n - 1, the last one left.
+   pmr::vector<int> code(n - 2, &tree_scratch());
+   pmr::vector<int> degree(n, 1, &tree_scratch());
+   uniform_int_distribution<int> vertex(0, n - 1);
+   for (int i = 0; i < n - 2; ++i) {
+      code[i] = vertex(g);
+      ++degree[code[i]];
+   }
+   // Linear decoding: leaf is the smallest leaf not removed yet but for the ones
+   // that become leaves behind it, which are removed as soon as they appear.
+   int leaf = 0;
+   while (degree[leaf] != 1) ++leaf;
+   int next = leaf;
+   for (int i = 0; i < n - 2; ++i) {
+      int v = code[i];
+      heads[next] = v + 1;
+      if (--degree[v] == 1 and v < leaf) next = v;
+      else {
+         ++leaf;
+         while (degree[leaf] != 1) ++leaf;
+         next = leaf;
+      }
+   }
+   assert(next != n - 1);
+   heads[next] = n;
+}
+
+void uniformly_random_arrangement(int n, int *position, mt19937_64 &g) {
+   assert(n >= 0);
+   // Fisher-Yates, building the permutation as it is shuffled
+   for (int i = 0; i < n; ++i) {
+      int j = uniform_int_distribution<int>(0, i)(g);
+      position[i] = position[j];
+      position[j] = i;
+   }
+}
+
+void arrange_tree(int n, const int *heads, const int *position, int *arranged_heads) {
+   for (int v = 0; v < n; ++v) {
+      assert(0 <= position[v] and position[v] < n);
+      arranged_heads[position[v]] = heads[v] == 0 ? 0 : position[heads[v] - 1] + 1;
+   }
+}
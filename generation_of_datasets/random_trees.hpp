@@ -0,0 +1,60 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _RANDOM_TREES_
+#define _RANDOM_TREES_
+
+#include <cstdint>
+#include <random>
+
+using namespace std;
+
+// Every thread draws from its own generator, so that the threads neither share
+// its state nor wait for each other. A thread that has not been seeded with
+// seed_random_generator is seeded the first time with the base seed (see
+// set_random_seed) mixed with a number that identifies the thread.
+mt19937_64 &random_generator();
+// Post: the generator of the calling thread restarts from seed
+void seed_random_generator(uint64_t seed);
+// Post: base seed of the threads that have not used their generator yet (1 by default)
+void set_random_seed(uint64_t seed);
+
+// The following ones write into buffers of n elements given by the caller,
+// and do not allocate memory beyond the scratch arena of the thread.
+
+// Pre: n >= 1
+// Post: heads[0], ..., heads[n - 1] are the heads, as in a .heads file (positions
+//       starting at 1, 0 for the root), of a uniformly random labelled free tree of
+//       n vertices, decoded from a uniformly random Prüfer sequence and rooted at
+//       vertex n - 1
+void uniformly_random_tree(int n, int *heads, mt19937_64 &g = random_generator());
+
+// Pre: n >= 0
+// Post: position[0], ..., position[n - 1] is a uniformly random permutation of 0, ..., n - 1
+void uniformly_random_arrangement(int n, int *position, mt19937_64 &g = random_generator());
+
+// Pre: position is a permutation of 0, ..., n - 1 and arranged_heads does not overlap heads
+// Post: arranged_heads are the heads of the tree of heads with every vertex v moved to position[v]
+void arrange_tree(int n, const int *heads, const int *position, int *arranged_heads);
+
+#endif
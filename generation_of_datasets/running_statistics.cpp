@@ -0,0 +1,183 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "running_statistics.hpp"
+
+quantile_sketch::quantile_sketch(int k) : k(k), n(0) {
+   assert(k >= 2);
+}
+
+void quantile_sketch::compact(size_t h) {
+   if (h + 1 == levels.size()) {
+      levels.push_back(vector<double>());
+      parity.push_back(0);
+   }
+   vector<double> &level = levels[h];
+   sort(level.begin(), level.end());
+   // an odd value out stays at this level
+   size_t kept = level.size() - level.size() % 2;
+   for (size_t i = parity[h]; i < kept; i += 2) levels[h + 1].push_back(level[i]);
+   parity[h] = 1 - parity[h];
+   level.erase(level.begin(), level.begin() + kept);
+   if (int(levels[h + 1].size()) >= k) compact(h + 1);
+}
+
+void quantile_sketch::insert(double x) {
+   if (levels.empty()) {
+      levels.push_back(vector<double>());
+      parity.push_back(0);
+   }
+   levels[0].push_back(x);
+   ++n;
+   if (int(levels[0].size()) >= k) compact(0);
+}
+
+void quantile_sketch::merge(const quantile_sketch &s) {
+   while (levels.size() < s.levels.size()) {
+      levels.push_back(vector<double>());
+      parity.push_back(0);
+   }
+   for (size_t h = 0; h < s.levels.size(); ++h) {
+      levels[h].insert(levels[h].end(), s.levels[h].begin(), s.levels[h].end());
+   }
+   for (size_t h = 0; h < levels.size(); ++h) {
+      if (int(levels[h].size()) >= k) compact(h);
+   }
+   n += s.n;
+}
+
+double quantile_sketch::samples() const {
+   return n;
+}
+
+double quantile_sketch::quantile(double q) const {
+   assert(n > 0);
+   assert(0 <= q and q <= 1);
+   vector<pair<double, double> > weighted;
+   double weight = 1;
+   for (size_t h = 0; h < levels.size(); ++h) {
+      for (size_t i = 0; i < levels[h].size(); ++i) weighted.push_back(make_pair(levels[h][i], weight));
+      weight *= 2;
+   }
+   sort(weighted.begin(), weighted.end());
+   double total = 0;
+   for (size_t i = 0; i < weighted.size(); ++i) total += weighted[i].second;
+   double accumulated = 0;
+   for (size_t i = 0; i < weighted.size(); ++i) {
+      accumulated += weighted[i].second;
+      if (accumulated >= q*total) return weighted[i].first;
+   }
+   return weighted.back().first;
+}
+
+running_statistics::running_statistics(median_method method, int sketch_size) :
+   n(0), average(0), m2(0), minimum(numeric_limits<double>::infinity()), maximum(-numeric_limits<double>::infinity()),
+   method(method), sketch(sketch_size) {
+}
+
+void running_statistics::insert(double x) {
+   ++n;
+   double delta = x - average;
+   average += delta/n;
+   m2 += delta*(x - average);
+   minimum = std::min(minimum, x);
+   maximum = std::max(maximum, x);
+   if (method == exact_median) values.push_back(x);
+   else if (method == sketched_median) sketch.insert(x);
+}
+
+void running_statistics::merge(const running_statistics &s) {
+   assert(method == s.method);
+   if (s.n == 0) return;
+   if (n == 0) {
+      *this = s; // same result as inserting the samples of s one by one
+      return;
+   }
+   double total = n + s.n;
+   double delta = s.average - average;
+   average += delta*s.n/total;
+   m2 += s.m2 + delta*delta*n*s.n/total;
+   n = total;
+   minimum = std::min(minimum, s.minimum);
+   maximum = std::max(maximum, s.maximum);
+   if (method == exact_median) values.insert(values.end(), s.values.begin(), s.values.end());
+   else if (method == sketched_median) sketch.merge(s.sketch);
+}
+
+double running_statistics::samples() const {
+   return n;
+}
+
+double running_statistics::mean() const {
+   return average;
+}
+
+double running_statistics::variance() const {
+   if (n == 0) return 0;
+   return std::max(m2/n, 0.0);
+}
+
+double running_statistics::stdev() const {
+   return sqrt(variance());
+}
+
+double running_statistics::min() const {
+   assert(n > 0);
+   return minimum;
+}
+
+double running_statistics::max() const {
+   assert(n > 0);
+   return maximum;
+}
+
+bool running_statistics::has_median() const {
+   return method != no_median;
+}
+
+double running_statistics::median() const {
+   assert(has_median());
+   if (n == 0) return numeric_limits<double>::quiet_NaN();
+   if (method == sketched_median) return sketch.quantile(0.5);
+   size_t middle = values.size()/2;
+   nth_element(values.begin(), values.begin() + middle, values.end());
+   if (values.size() % 2 == 1) return values[middle];
+   // the other middle value is the largest one before it
+   double lower = *max_element(values.begin(), values.begin() + middle);
+   return (lower + values[middle])/2.0;
+}
+
+block_statistics::block_statistics(size_t block_size, median_method method, int sketch_size) :
+   running_statistics(method, sketch_size), block(block_size, 0.0), first(0) {
+}
+
+void block_statistics::flush(size_t count) {
+   assert(count <= block.size());
+   for (size_t i = 0; i < count; ++i) insert(block[i]);
+   first += count;
+}
@@ -0,0 +1,112 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _RUNNING_STATISTICS_
+#define _RUNNING_STATISTICS_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Bounded memory summary of a sample to estimate its quantiles. The values
+ * at level h stand for 2^h values each. When a level holds k values, they
+ * are sorted and every other one goes up one level, alternating the first
+ * one kept so that the errors do not pile up on one side. The summary is
+ * deterministic: the same insertions and merges give the same estimates.
+ */
+class quantile_sketch {
+private:
+   int k;
+   vector<vector<double> > levels;
+   vector<char> parity; // of the first value kept when compacting each level
+   double n;
+   void compact(size_t h);
+public:
+   quantile_sketch(int k = 256);
+   void insert(double x);
+   void merge(const quantile_sketch &s);
+   double samples() const;
+   // Pre: samples() > 0, 0 <= q <= 1
+   double quantile(double q) const;
+};
+
+enum median_method { exact_median, sketched_median, no_median };
+
+/**
+ * Mean, variance and median of a sample seen one value at a time.
+ * The mean and the variance are updated with Welford's recurrence, so they
+ * need no memory for the values. The median is exact if the values are kept
+ * (they are partially sorted in place when it is asked for), estimated with a
+ * quantile_sketch, or not available.
+ * Two statistics can be merged, as if the values of the second one had been
+ * inserted after those of the first one.
+ */
+class running_statistics {
+private:
+   double n;
+   double average;
+   double m2; // sum of squared deviations from the mean
+   double minimum;
+   double maximum;
+   median_method method;
+   mutable vector<double> values;
+   quantile_sketch sketch;
+public:
+   running_statistics(median_method method = exact_median, int sketch_size = 256);
+   void insert(double x);
+   void merge(const running_statistics &s);
+   double samples() const;
+   // mean, variance and stdev are 0 if there are no samples
+   double mean() const;
+   double variance() const; // of the population, dividing by samples()
+   double stdev() const;
+   // Pre: samples() > 0
+   double min() const;
+   double max() const;
+   bool has_median() const;
+   // Pre: has_median()
+   // NaN if there are no samples, as the median of an empty sample is undefined
+   double median() const;
+};
+
+/**
+ * running_statistics of a metric computed for blocks of trees in parallel:
+ * values are written to the slots of the trees of the current block, in any
+ * order, and flush inserts them in the order of the trees.
+ */
+class block_statistics : public running_statistics {
+private:
+   vector<double> block;
+   size_t first; // tree of the first slot
+public:
+   block_statistics(size_t block_size, median_method method = exact_median, int sketch_size = 256);
+   // Pre: first tree of the current block <= i < that tree + block size
+   double &operator[](size_t i) { return block[i - first]; }
+   // Post: the values of the trees first, ..., first + count - 1 have been
+   // inserted and the next block starts at tree first + count
+   void flush(size_t count);
+};
+
+#endif
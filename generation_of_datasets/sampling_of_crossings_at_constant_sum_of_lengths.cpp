@@ -0,0 +1,215 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include "sampling_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "fast_prediction_of_crossings_at_constant_sum_of_lengths.hpp"
+#include "tree_metrics.hpp"
+
+// quantile of the standard normal distribution for 95% confidence intervals
+static const double z_95 = 1.959963984540054;
+// the chain takes at most this many steps per sample asked for
+static const long long steps_per_sample_max = 1000;
+// the batches of the batch means are long enough to be almost independent if there are few of them
+static const size_t batches_max = 30;
+// the burn-in runs rounds of this many steps per vertex from the arrangement of the tree, starting
+// with beta_max, and decreases beta by beta_step while the chain is at the target sum of lengths more
+// than time_at_target_max of the time, or increases it if less than time_at_target_min
+static const int burn_in_steps_per_vertex = 1000;
+static const int burn_in_rounds_max = 20;
+static const double beta_max = 5;
+static const double beta_step = 0.5;
+static const double time_at_target_min = 0.02;
+static const double time_at_target_max = 0.1;
+
+crossings_sampling::crossings_sampling(): min_samples(10000), max_samples(100000), standard_error(0.01) {
+}
+
+// Post: the standard error of the mean of x by nonoverlapping batch means
+static double batch_means_standard_error(const vector<int> &x) {
+   size_t batches = min(size_t(sqrt(double(x.size()))), batches_max);
+   if (batches < 2) return numeric_limits<double>::infinity();
+   size_t batch_size = x.size()/batches;
+   double mean = 0;
+   vector<double> batch_mean(batches, 0);
+   for (size_t b = 0; b < batches; ++b) {
+      for (size_t i = b*batch_size; i < (b + 1)*batch_size; ++i) batch_mean[b] += x[i];
+      batch_mean[b] /= batch_size;
+      mean += batch_mean[b];
+   }
+   mean /= batches;
+   double variance = 0;
+   for (size_t b = 0; b < batches; ++b) variance += (batch_mean[b] - mean)*(batch_mean[b] - mean);
+   variance /= batches - 1;
+   return sqrt(variance/batches);
+}
+
+// Metropolis chain over the arrangements of a tree, see sample_crossings_at_constant_sum_of_lengths
+class arrangement_chain {
+   const undirected_graph &g;
+   int n;
+   int target; // sum of lengths D
+   double beta;
+   vector<int> start; // arrangement of g
+   vector<int> position; // of every vertex
+   vector<int> vertex_at; // every position
+   vector<int> parent; // of every vertex in g rooted at 0, -1 for the root
+   vector<int> heads; // of the current arrangement
+   int sum_of_lengths;
+   uniform_int_distribution<int> vertex;
+   uniform_real_distribution<double> uniform;
+public:
+   arrangement_chain(const undirected_graph &g): g(g), n(g.vertices()), target(g.edge_length_sum()), beta(beta_max), start(n), position(n), vertex_at(n), parent(n, -1), heads(n), sum_of_lengths(target), vertex(0, n - 1), uniform(0, 1) {
+      for (int v = 0; v < n; ++v) start[v] = v;
+      restart();
+      vector<int> stack(1, 0);
+      vector<bool> visited(n, false);
+      visited[0] = true;
+      while (not stack.empty()) {
+         int u = stack.back();
+         stack.pop_back();
+         for (neighbourhood::const_iterator w = g.adjacent[u].begin(); w != g.adjacent[u].end(); ++w) {
+            if (visited[*w]) continue;
+            visited[*w] = true;
+            parent[*w] = u;
+            stack.push_back(*w);
+         }
+      }
+   }
+   // Post: the chain is back at the arrangement of g
+   void restart() {
+      position = start;
+      for (int v = 0; v < n; ++v) vertex_at[position[v]] = v;
+      sum_of_lengths = target;
+   }
+   double get_beta() const {
+      return beta;
+   }
+   void set_beta(double b) {
+      beta = b;
+   }
+   bool at_target() const {
+      return sum_of_lengths == target;
+   }
+   // Post: a swap of two vertices has been proposed, and accepted with the probability of Metropolis
+   void step(mt19937_64 &random) {
+      // half of the swaps are of two vertices next to each other, which change the sum less
+      int u = vertex(random);
+      int v;
+      if (random() & 1) v = vertex(random);
+      else if (position[u] + 1 < n) v = vertex_at[position[u] + 1];
+      else return;
+      if (u == v) return;
+      // only the edges of u and v other than (u, v) change their length
+      int change = 0;
+      for (neighbourhood::const_iterator w = g.adjacent[u].begin(); w != g.adjacent[u].end(); ++w) {
+         if (*w != v) change += abs(position[v] - position[*w]) - abs(position[u] - position[*w]);
+      }
+      for (neighbourhood::const_iterator w = g.adjacent[v].begin(); w != g.adjacent[v].end(); ++w) {
+         if (*w != u) change += abs(position[u] - position[*w]) - abs(position[v] - position[*w]);
+      }
+      int farther = abs(sum_of_lengths + change - target) - abs(sum_of_lengths - target);
+      if (farther > 0 and uniform(random) >= exp(-beta*farther)) return;
+      swap(position[u], position[v]);
+      vertex_at[position[u]] = u;
+      vertex_at[position[v]] = v;
+      sum_of_lengths += change;
+   }
+   int crossings() {
+      for (int w = 0; w < n; ++w) heads[position[w]] = parent[w] < 0 ? 0 : position[parent[w]] + 1;
+      return compute_tree_metrics(heads.data(), n, metric_C).C;
+   }
+};
+
+crossings_estimate sample_crossings_at_constant_sum_of_lengths(const undirected_graph &g, const crossings_sampling &s, mt19937_64 &random) {
+   assert(g.tree());
+   int n = g.vertices();
+   crossings_estimate e = crossings_estimate();
+   if (n < 4) {
+      // no two edges can cross
+      e.exact = true;
+      return e;
+   }
+   arrangement_chain chain(g);
+   // burn-in: the smallest beta (within beta_step) at which the chain still spends enough time at
+   // the target sum; the chain goes back to the arrangement of g when beta increases, since it may be
+   // far from any arrangement at the target sum
+   long long round_steps = (long long)(burn_in_steps_per_vertex)*n;
+   for (int round = 0; round < burn_in_rounds_max; ++round) {
+      long long at_target = 0;
+      for (long long step = 0; step < round_steps; ++step) {
+         chain.step(random);
+         at_target += chain.at_target();
+      }
+      double beta = chain.get_beta();
+      if (at_target < time_at_target_min*round_steps) {
+         chain.set_beta(beta + beta_step);
+         chain.restart();
+      }
+      else if (at_target > time_at_target_max*round_steps and beta > beta_step) chain.set_beta(beta - beta_step);
+      else break;
+   }
+   vector<int> crossings;
+   crossings.reserve(min<long long>(s.max_samples, 1 << 20));
+   long long steps_max = s.max_samples*steps_per_sample_max;
+   long long next_check = s.min_samples;
+   for (long long step = 1; step <= steps_max and (long long)(crossings.size()) < s.max_samples; ++step) {
+      chain.step(random);
+      if (step % n == 0 and chain.at_target()) {
+         crossings.push_back(chain.crossings());
+         if ((long long)(crossings.size()) >= next_check) {
+            if (batch_means_standard_error(crossings) <= s.standard_error) break;
+            next_check += max<long long>(1, crossings.size()/10);
+         }
+      }
+   }
+   if (crossings.empty()) {
+      // the chain never came back to the target sum: no estimate
+      e.mean = e.lower = e.upper = numeric_limits<double>::quiet_NaN();
+      e.standard_error = numeric_limits<double>::infinity();
+      return e;
+   }
+   double sum = 0;
+   for (size_t i = 0; i < crossings.size(); ++i) sum += crossings[i];
+   e.mean = sum/crossings.size();
+   e.standard_error = batch_means_standard_error(crossings);
+   e.lower = e.mean - z_95*e.standard_error;
+   e.upper = e.mean + z_95*e.standard_error;
+   e.samples = crossings.size();
+   e.exact = false;
+   return e;
+}
+
+crossings_estimate expected_crossings_at_constant_sum_of_lengths(const undirected_graph &g, int exact_vertices, const crossings_sampling &s, mt19937_64 &random) {
+   if (g.vertices() > exact_vertices) return sample_crossings_at_constant_sum_of_lengths(g, s, random);
+   crossings_estimate e = crossings_estimate();
+   e.mean = g.vertices() < 4 ? 0 : crossings_at_constant_sum_of_lengths(g);
+   e.lower = e.upper = e.mean;
+   e.exact = true;
+   return e;
+}
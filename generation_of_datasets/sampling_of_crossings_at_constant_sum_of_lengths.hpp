@@ -0,0 +1,63 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _SAMPLING_OF_CROSSINGS_AT_CONSTANT_SUM_OF_LENGTHS_
+#define _SAMPLING_OF_CROSSINGS_AT_CONSTANT_SUM_OF_LENGTHS_
+
+#include <random>
+#include "undirected_graph.hpp"
+
+using namespace std;
+
+// How E[C|D] is estimated when the arrangements are too many to be enumerated
+struct crossings_sampling {
+   long long min_samples; // before the standard error is checked
+   long long max_samples;
+   double standard_error; // stop as soon as the standard error of the mean is at most this
+   crossings_sampling();
+};
+
+struct crossings_estimate {
+   double mean;
+   double standard_error; // 0 if exact
+   double lower; // 95% confidence interval
+   double upper;
+   long long samples; // 0 if exact, or if the chain never reached D (then mean is NaN)
+   bool exact;
+};
+
+// Post: estimate of the mean number of crossings over the arrangements of the tree g whose sum of
+//       edge lengths D is that of g. It is the mean of the crossings of a Markov chain that swaps two
+//       vertices at a time (Metropolis), whose stationary distribution gives every arrangement with
+//       sum of lengths D' a weight exp(-beta |D' - D|): it is positive everywhere and the swaps connect
+//       all the arrangements, so the chain is irreducible, and the arrangements with sum D are equally
+//       likely. beta is tuned during the burn-in until the chain is at D often enough, and then
+//       fixed; the crossings are taken every n steps that end at D. The standard error is estimated by
+//       batch means.
+crossings_estimate sample_crossings_at_constant_sum_of_lengths(const undirected_graph &g, const crossings_sampling &s, mt19937_64 &random);
+
+// Post: E[C|D] as above, exact (see crossings_at_constant_sum_of_lengths) if g has at most
+//       exact_vertices vertices, sampled otherwise
+crossings_estimate expected_crossings_at_constant_sum_of_lengths(const undirected_graph &g, int exact_vertices, const crossings_sampling &s, mt19937_64 &random);
+
+#endif
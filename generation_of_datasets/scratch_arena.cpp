@@ -0,0 +1,118 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include "scratch_arena.hpp"
+
+scratch_arena::scratch_arena(size_t capacity): block(NULL), capacity(capacity), used(0), overflow(NULL), overflow_bytes(0), depth(0) {
+   block = static_cast<char *>(::operator new(capacity));
+}
+
+scratch_arena::~scratch_arena() {
+   assert(depth == 0);
+   reset();
+   ::operator delete(block);
+}
+
+void *scratch_arena::do_allocate(size_t bytes, size_t alignment) {
+   assert(depth > 0);
+   assert(alignment <= alignof(max_align_t));
+   size_t start = (used + alignment - 1) & ~(alignment - 1);
+   if (start <= capacity and bytes <= capacity - start) {
+      used = start + bytes;
+      return block + start;
+   }
+   overflow_chunk *c = static_cast<overflow_chunk *>(::operator new(offsetof(overflow_chunk, memory) + bytes));
+   c->next = overflow;
+   overflow = c;
+   overflow_bytes += bytes + alignment;
+   return c->memory;
+}
+
+void scratch_arena::do_deallocate(void *p, size_t bytes, size_t alignment) {
+   // given back by reset
+}
+
+bool scratch_arena::do_is_equal(const pmr::memory_resource &other) const noexcept {
+   return this == &other;
+}
+
+void scratch_arena::reset() {
+   if (overflow != NULL) {
+      while (overflow != NULL) {
+         overflow_chunk *c = overflow;
+         overflow = c->next;
+         ::operator delete(c);
+      }
+      // room for everything this computation needed, and some more
+      capacity = 2*(used + overflow_bytes);
+      overflow_bytes = 0;
+      ::operator delete(block);
+      block = static_cast<char *>(::operator new(capacity));
+   }
+   used = 0;
+}
+
+void scratch_arena::enter() {
+   ++depth;
+}
+
+void scratch_arena::leave() {
+   assert(depth > 0);
+   if (--depth == 0) reset();
+}
+
+size_t scratch_arena::block_size() const {
+   return capacity;
+}
+
+scratch_arena &tree_scratch() {
+   static thread_local scratch_arena arena;
+   return arena;
+}
+
+#ifdef COUNT_ALLOCATIONS
+static atomic<long long> allocations(0);
+
+long long allocation_count() {
+   return allocations.load();
+}
+
+void *operator new(size_t bytes) {
+   ++allocations;
+   void *p = malloc(bytes == 0 ? 1 : bytes);
+   if (p == NULL) throw bad_alloc();
+   return p;
+}
+
+void operator delete(void *p) noexcept {
+   free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+   free(p);
+}
+#endif
@@ -0,0 +1,93 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _SCRATCH_ARENA_
+#define _SCRATCH_ARENA_
+
+#include <cstddef>
+#include <memory_resource>
+
+using namespace std;
+
+/**
+ * Monotonic memory for the temporary vectors of the metrics of one tree:
+ * allocating is moving a pointer forward, deallocating does nothing, and all
+ * the memory is given back at once when the outermost scratch_scope ends.
+ * When a tree does not fit in the block, the excess is taken from new and
+ * the block is enlarged at the next reset, so once the largest tree has been
+ * seen the metrics of a tree do not call malloc at all.
+ */
+class scratch_arena: public pmr::memory_resource {
+private:
+   struct overflow_chunk {
+      overflow_chunk *next;
+      alignas(max_align_t) char memory[1];
+   };
+   char *block;
+   size_t capacity;
+   size_t used;
+   overflow_chunk *overflow;
+   size_t overflow_bytes;
+   int depth;
+   void *do_allocate(size_t bytes, size_t alignment) override;
+   void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+   bool do_is_equal(const pmr::memory_resource &other) const noexcept override;
+   void reset();
+public:
+   scratch_arena(size_t capacity = 1 << 16);
+   ~scratch_arena();
+   scratch_arena(const scratch_arena &) = delete;
+   scratch_arena &operator=(const scratch_arena &) = delete;
+   // the memory allocated after the outermost enter is released by its leave
+   void enter();
+   void leave();
+   size_t block_size() const;
+};
+
+// Post: the arena of the calling thread
+scratch_arena &tree_scratch();
+
+// Marks the lifetime of the scratch memory of a computation: it has to be
+// declared before the containers that draw from tree_scratch().
+class scratch_scope {
+public:
+   scratch_scope();
+   ~scratch_scope();
+   scratch_scope(const scratch_scope &) = delete;
+   scratch_scope &operator=(const scratch_scope &) = delete;
+};
+
+inline scratch_scope::scratch_scope() {
+   tree_scratch().enter();
+}
+
+inline scratch_scope::~scratch_scope() {
+   tree_scratch().leave();
+}
+
+#ifdef COUNT_ALLOCATIONS
+// Post: the number of calls to the global operator new made so far by all threads
+long long allocation_count();
+#endif
+
+#endif
@@ -28,6 +28,7 @@
  ********************************************************************/
 
 #include "common.hpp"
+#include "scratch_arena.hpp"
 
 uint32_t get_v_star(adjacency_matrix & g, const size_matrix & s, const vector<uint32_t> & list_of_nodes)
 // For free (unanchored) trees
@@ -261,7 +262,7 @@ void calculate_mla(adjacency_matrix & g, int alpha, uint32_t root_or_anchor, uin
 	}
 }
 
-uint32_t calculate_D_min_Shiloach(uint32_t n, list<pair<uint32_t,uint32_t> >&tree) { 
+uint32_t calculate_D_min_Shiloach_matrix(uint32_t n, list<pair<uint32_t,uint32_t> >&tree) { 
 	 
    adjacency_matrix g;
    convert_tree_to_matrix(n,tree,g);
@@ -274,3 +275,108 @@ uint32_t calculate_D_min_Shiloach(uint32_t n, list<pair<uint32_t,uint32_t> >&tre
    return c;
 }
 
+uint32_t get_v_star(const tree_adjacency & t)
+// Same as get_v_star above for the nodes in t.preorder
+{
+	uint32_t number_of_nodes=t.preorder.size();
+	uint32_t h=number_of_nodes/2;
+	for (uint32_t i=0;i<number_of_nodes;++i){
+		uint32_t u=t.preorder[i];
+		bool tree_too_big=false;
+		for (uint32_t a=t.begin(u);a<t.end(u) and not tree_too_big;++a){
+			if (not t.is_cut(a) and t.size_of_subtree(u,t.node(a))>h) tree_too_big=true;
+		}
+		if (not tree_too_big) return u;
+	}
+	return 0;
+}
+
+uint32_t calculate_mla_cost(tree_adjacency & t, int alpha, uint32_t root_or_anchor)
+// Cost of the arrangement calculate_mla would produce, 
+// without building the adjacency matrix nor the arrangement.
+// The edges of t are cut and joined back as g in calculate_mla.
+// Every call roots its whole component again, so the time is O(n^2) in the
+// worst case, e.g. for a star, whose component loses one leaf per level.
+{
+	assert(alpha==NO_ANCHOR or alpha==RIGHT_ANCHOR or alpha==LEFT_ANCHOR);
+
+	uint32_t size_tree=t.root_subtree(root_or_anchor); // Size of the tree
+	assert(size_tree>0);
+	
+	// Base case
+	if (size_tree==1) return 0;
+	
+	// Recursion for COST A
+	uint32_t v_star;
+	if (alpha==NO_ANCHOR) v_star=get_v_star(t);
+	else v_star=root_or_anchor;
+	
+	// t.preorder, t.parent and t.size are overwritten by the recursive calls
+	ordering ord(t.memory());
+	t.order_subtrees_by_size(v_star,ord);
+
+	uint32_t v_0,n_0;  	
+	v_0=ord[0].second; // Root of biggest subtree
+	n_0=ord[0].first; // Size of biggest subtree 
+	
+	t.cut(v_star,v_0);
+	
+	uint32_t c1,c2;
+	
+	c1=calculate_mla_cost(t,RIGHT_ANCHOR,v_0);
+	if (alpha==NO_ANCHOR) c2=calculate_mla_cost(t,LEFT_ANCHOR,v_star);
+	else c2=calculate_mla_cost(t,NO_ANCHOR,v_star);
+	
+	// Cost for A-recursion
+	uint32_t cost;
+	if (alpha==NO_ANCHOR) cost=c1+c2+1;
+	else cost=c1+c2+size_tree-n_0; 
+		
+	t.join(v_star,v_0);
+	
+	// Recursion B
+	uint32_t s_0,s_1;
+	uint32_t p_alpha=0;
+	
+	// left or right anchored is not important for the cost
+	uint32_t anchored = NO_ANCHOR;
+	if (alpha==RIGHT_ANCHOR or alpha==LEFT_ANCHOR) anchored=ANCHOR;
+	
+	p_alpha=calculate_p(v_star,anchored,ord,s_0,s_1); 
+	
+	if (p_alpha!=0){
+		uint32_t cost_B=0;
+		for (uint32_t i=1;i<=2*p_alpha-anchored;++i) t.cut(v_star,ord[i].second);
+		// T_1, T_3, ...
+		for (uint32_t i=1;i<=2*p_alpha-anchored;i=i+2){
+			cost_B+=calculate_mla_cost(t,RIGHT_ANCHOR,ord[i].second);
+		}
+		// T-(T_1, T_2, ...)
+		cost_B+=calculate_mla_cost(t,NO_ANCHOR,v_star);
+		// ..., T_4, T_2
+		for (uint32_t i=2*p_alpha-2*anchored;i>=2;i=i-2){
+			cost_B+=calculate_mla_cost(t,LEFT_ANCHOR,ord[i].second);
+		}
+		for (uint32_t i=1;i<=2*p_alpha-anchored;++i) t.join(v_star,ord[i].second);
+	
+		// We add the anchors part not previously added
+		if (alpha==NO_ANCHOR) cost_B+=s_0;
+		else cost_B+=s_1;
+
+		// We choose B-recursion only if it is better
+		if (cost_B<cost) cost=cost_B;
+	}
+	return cost;
+}
+
+uint32_t calculate_D_min_Shiloach(uint32_t n, const edge_vector & tree)
+// Same value as calculate_D_min_Shiloach_matrix in O(n) space and O(n^2) time
+// in the worst case (see calculate_mla_cost).
+// The edges of tree are pairs of nodes labelled 1, 2, ..., n.
+{
+   if (n==0) return 0;
+   scratch_scope scope;
+   tree_adjacency t(n,tree,&tree_scratch());
+   return calculate_mla_cost(t,NO_ANCHOR,1);
+}
+
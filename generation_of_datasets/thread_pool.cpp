@@ -0,0 +1,188 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "thread_pool.hpp"
+
+// worker running in the current thread, -1 outside the pool
+static thread_local int current_worker = -1;
+
+thread_pool::thread_pool(int threads) : queued(0), stop(false) {
+   assert(threads >= 1);
+   for (int i = 0; i < threads; ++i) queues.push_back(unique_ptr<task_queue>(new task_queue));
+   // the thread that waits for the tasks is the last one
+   for (int i = 0; i < threads - 1; ++i) workers.push_back(thread(&thread_pool::work, this, i));
+}
+
+thread_pool::~thread_pool() {
+   {
+      lock_guard<mutex> l(sleep_lock);
+      stop = true;
+   }
+   wake_up.notify_all();
+   for (int i = 0; i < int(workers.size()); ++i) workers[i].join();
+}
+
+int thread_pool::threads() const {
+   return queues.size();
+}
+
+int thread_pool::own_queue() const {
+   return current_worker >= 0 ? current_worker : int(queues.size()) - 1;
+}
+
+bool thread_pool::take(int q, bool back, task &t) {
+   lock_guard<mutex> l(queues[q]->lock);
+   deque<task> &tasks = queues[q]->tasks;
+   if (tasks.empty()) return false;
+   // moved, not copied: a copy of a function may allocate
+   if (back) {
+      t = std::move(tasks.back());
+      tasks.pop_back();
+   }
+   else {
+      t = std::move(tasks.front());
+      tasks.pop_front();
+   }
+   --queued;
+   return true;
+}
+
+void thread_pool::submit(task_group &group, function<void()> f) {
+   ++group.pending;
+   int q = own_queue();
+   {
+      lock_guard<mutex> l(queues[q]->lock);
+      queues[q]->tasks.push_back(task(std::move(f), &group));
+   }
+   ++queued;
+   {
+      // a worker going to sleep sees the new task or is woken up
+      lock_guard<mutex> l(sleep_lock);
+   }
+   wake_up.notify_one();
+}
+
+bool thread_pool::run_pending_task() {
+   int own = own_queue();
+   int q = int(queues.size());
+   task t;
+   bool found = take(own, true, t);
+   for (int i = 1; i < q and not found; ++i) found = take((own + i) % q, false, t);
+   if (not found) return false;
+   task_group &group = *t.second;
+   try {
+      t.first();
+   }
+   catch (...) {
+      lock_guard<mutex> l(sleep_lock);
+      if (not group.error) group.error = current_exception();
+   }
+   if (--group.pending == 0) {
+      // the thread waiting for the group either sees pending == 0 or is woken up;
+      // the group may not exist anymore
+      {
+         lock_guard<mutex> l(sleep_lock);
+      }
+      wake_up.notify_all();
+   }
+   return true;
+}
+
+void thread_pool::wait(task_group &group) {
+   while (group.pending > 0) {
+      if (run_pending_task()) continue;
+      unique_lock<mutex> l(sleep_lock);
+      wake_up.wait(l, [this, &group] { return group.pending == 0 or queued > 0; });
+   }
+}
+
+void thread_pool::work(int worker) {
+   current_worker = worker;
+   while (true) {
+      if (run_pending_task()) continue;
+      unique_lock<mutex> l(sleep_lock);
+      wake_up.wait(l, [this] { return stop or queued > 0; });
+      if (stop and queued == 0) return;
+   }
+}
+
+task_group::task_group(thread_pool *pool) : pool(pool), pending(0) {
+}
+
+task_group::~task_group() {
+   // the exception of a task is lost if nobody waited for it
+   if (pool != NULL) pool->wait(*this);
+}
+
+void task_group::run(function<void()> f) {
+   if (pool == NULL) f();
+   else pool->submit(*this, std::move(f));
+}
+
+bool task_group::done() const {
+   return pending == 0;
+}
+
+void task_group::wait() {
+   if (pool == NULL) return;
+   pool->wait(*this);
+   if (error) {
+      exception_ptr e = error;
+      error = nullptr;
+      rethrow_exception(e);
+   }
+}
+
+static unique_ptr<thread_pool> pool;
+
+void set_threads(int threads) {
+   assert(threads >= 1);
+   pool.reset();
+   if (threads > 1) pool.reset(new thread_pool(threads));
+}
+
+thread_pool *default_thread_pool() {
+   return pool.get();
+}
+
+void parallel_for(size_t n, size_t grain, const function<void(size_t, size_t)> &body) {
+   grain = max(grain, size_t(1));
+   if (pool == NULL or n <= grain) {
+      if (n > 0) body(0, n);
+      return;
+   }
+   // a few chunks per thread so that the stealing evens out trees of different sizes
+   grain = max(grain, n/(8*pool->threads()));
+   // every task captures two words, which a function keeps without allocating
+   struct chunks {
+      const function<void(size_t, size_t)> &body;
+      size_t n, grain;
+   } c = { body, n, grain };
+   task_group group(pool.get());
+   for (size_t begin = 0; begin < n; begin += grain) {
+      group.run([&c, begin] { c.body(begin, min(c.n, begin + c.grain)); });
+   }
+   group.wait();
+}
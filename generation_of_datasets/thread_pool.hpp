@@ -0,0 +1,109 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _THREAD_POOL_
+#define _THREAD_POOL_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class task_group;
+
+/**
+ * Work-stealing pool of threads. Every worker runs the tasks at the back of
+ * its own deque and, when it is empty, steals the task at the front of the
+ * deque of another worker. Tasks submitted from threads outside the pool go to
+ * a deque shared by all of them. A thread waiting for a task_group runs
+ * pending tasks in the meantime, so tasks can submit tasks and wait for them,
+ * and sleeps when there are none until a task is submitted or the group is done.
+ */
+class thread_pool {
+private:
+   typedef pair<function<void()>, task_group *> task;
+   struct task_queue {
+      mutex lock;
+      deque<task> tasks;
+   };
+   vector<unique_ptr<task_queue> > queues; // one per worker and the shared one, last
+   vector<thread> workers;
+   atomic<long> queued; // tasks in the queues
+   mutex sleep_lock;
+   condition_variable wake_up;
+   bool stop;
+   int own_queue() const;
+   bool take(int q, bool back, task &t);
+   void work(int worker);
+public:
+   // Pre: threads >= 1, counting the thread that waits for the tasks
+   thread_pool(int threads);
+   ~thread_pool();
+   int threads() const;
+   void submit(task_group &group, function<void()> f);
+   // Post: false if there were no tasks to run
+   bool run_pending_task();
+   // Post: the tasks of group are done; the calling thread runs pending tasks meanwhile
+   void wait(task_group &group);
+};
+
+/**
+ * Tasks that can be waited for together. Without a pool, every task runs
+ * as soon as it is submitted. If a task throws, the rest of the tasks still
+ * run and wait rethrows the first exception.
+ */
+class task_group {
+private:
+   friend class thread_pool;
+   thread_pool *pool;
+   atomic<int> pending;
+   exception_ptr error; // thrown by a task, guarded by the sleep_lock of the pool
+   task_group(const task_group &);
+   task_group &operator=(const task_group &);
+public:
+   task_group(thread_pool *pool);
+   ~task_group();
+   void run(function<void()> f);
+   bool done() const;
+   void wait();
+};
+
+// Pre: threads >= 1
+// Post: parallel_for uses threads threads, none other than the caller if threads == 1
+void set_threads(int threads);
+// Post: NULL if there is a single thread
+thread_pool *default_thread_pool();
+// Calls body(begin, end) on consecutive intervals covering 0, 1, ..., n - 1,
+// of at least grain elements (but the last one), in parallel if possible
+void parallel_for(size_t n, size_t grain, const function<void(size_t, size_t)> &body);
+
+#endif
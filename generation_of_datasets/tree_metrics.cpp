@@ -0,0 +1,149 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "tree_metrics.hpp"
+#include "common.hpp"
+#include "scratch_arena.hpp"
+
+// Pre: the right endpoints of the edges whose left (smaller) endpoint is i are
+//      right[first[i]], ..., right[first[i + 1] - 1], 0 <= i < n
+// Post: the number of pairs of edges that cross
+static int crossings_of_edges(int n, const pmr::vector<int> &first, const pmr::vector<int> &right) {
+   // Same sweep as undirected_graph::crossings_lazy: the edges with left endpoint i
+   // cross the edges visited before whose right endpoint lies strictly between
+   // their endpoints, and they are added to the Fenwick tree after being counted.
+   int crossings = 0;
+   if (n < 4) return 0;
+   pmr::vector<int> right_endpoints(n + 1, 0, &tree_scratch()); // Fenwick tree: vertex v is at position v + 1
+   for (int i = 0; i < n; ++i) {
+      for (int k = first[i]; k < first[i + 1]; ++k) {
+         for (int x = right[k]; x > 0; x -= x & -x) crossings += right_endpoints[x];
+         for (int x = i + 1; x > 0; x -= x & -x) crossings -= right_endpoints[x];
+      }
+      for (int k = first[i]; k < first[i + 1]; ++k) {
+         for (int x = right[k] + 1; x <= n; x += x & -x) ++right_endpoints[x];
+      }
+   }
+   int edges = right.size();
+   assert(crossings <= edges*(edges - 1)/2);
+   return crossings;
+}
+
+// Post: D_random and, if it is in features, Omega have been set from n, D and D_min
+static void set_omega(tree_metrics &m, unsigned features) {
+   int n = m.n;
+   m.D_random = (n - 1)*(n + 1)/double(3);
+   if (features & metric_Omega) {
+      m.Omega = n >= 3 ? (m.D_random - m.D)/(m.D_random - m.D_min) : numeric_limits<double>::quiet_NaN();
+   }
+}
+
+tree_metrics compute_tree_metrics(const dependency_tree &t, unsigned features) {
+   if (features & metric_Omega) features |= metric_D | metric_D_min;
+   int n = t.vertices();
+   tree_metrics m = tree_metrics();
+   m.n = n;
+   // all the vectors are released together at the end
+   scratch_scope scope;
+   pmr::memory_resource *scratch = &tree_scratch();
+   // one sweep over the heads for the degrees, D and the edges for Shiloach's algorithm
+   pmr::vector<int> degree(scratch);
+   if (features & metric_K2) degree.assign(n, 0);
+   edge_vector l(scratch);
+   if (features & metric_D_min) l.reserve(n);
+   if (features & (metric_K2 | metric_D | metric_D_min)) {
+      for (int v = 0; v < n; ++v) {
+         int h = t.head(v);
+         if (h < 0) continue;
+         if (features & metric_K2) {
+            ++degree[v];
+            ++degree[h];
+         }
+         m.D += t.edge_length(v);
+         if (features & metric_D_min) l.push_back(pair<uint32_t, uint32_t>(v + 1, h + 1));
+      }
+      if (not (features & metric_D)) m.D = 0;
+   }
+   if (features & metric_K2) {
+      for (int v = 0; v < n; ++v) m.K2 += degree[v]*degree[v];
+   }
+   if (features & metric_D_min) {
+      assert(int(l.size()) == n - 1 or n == 0);
+      m.D_min = calculate_D_min_Shiloach(n, l);
+   }
+   // only the crossings need the edges sorted
+   if (features & metric_C) {
+      pmr::vector<int> first(scratch), right(scratch);
+      t.edges_by_left_endpoint(first, right);
+      m.C = crossings_of_edges(n, first, right);
+   }
+   set_omega(m, features);
+   return m;
+}
+
+tree_metrics compute_tree_metrics(const int *heads, int n, unsigned features) {
+   return compute_tree_metrics(dependency_tree(heads, n), features);
+}
+
+tree_metrics compute_tree_metrics(const undirected_graph &g, unsigned features) {
+   if (features & metric_Omega) features |= metric_D | metric_D_min;
+   int n = g.vertices();
+   tree_metrics m = tree_metrics();
+   m.n = n;
+   scratch_scope scope;
+   pmr::memory_resource *scratch = &tree_scratch();
+   // one sweep over the adjacency: the neighbours are in increasing order,
+   // so the edges come out grouped by left endpoint
+   pmr::vector<int> first(n + 1, 0, scratch);
+   pmr::vector<int> right(scratch);
+   right.reserve(g.edges());
+   for (int i = 0; i < n; ++i) {
+      neighbourhood N = g.adjacent[i];
+      if (features & metric_K2) m.K2 += N.size()*N.size();
+      for (neighbourhood::const_iterator j = N.begin(); j != N.end(); ++j) {
+         if (*j > i) right.push_back(*j);
+      }
+      first[i + 1] = right.size();
+   }
+   if (features & (metric_D | metric_D_min)) {
+      edge_vector l(scratch);
+      l.reserve(right.size());
+      for (int i = 0; i < n; ++i) {
+         for (int k = first[i]; k < first[i + 1]; ++k) {
+            if (features & metric_D) m.D += right[k] - i;
+            l.push_back(pair<uint32_t, uint32_t>(right[k] + 1, i + 1));
+         }
+      }
+      if (features & metric_D_min) {
+         assert(int(l.size()) == n - 1 or n == 0);
+         m.D_min = calculate_D_min_Shiloach(n, l);
+      }
+   }
+   if (features & metric_C) m.C = crossings_of_edges(n, first, right);
+   set_omega(m, features);
+   return m;
+}
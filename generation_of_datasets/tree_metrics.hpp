@@ -0,0 +1,66 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _TREE_METRICS_
+#define _TREE_METRICS_
+
+#include "undirected_graph.hpp"
+#include "dependency_tree.hpp"
+
+using namespace std;
+
+// The metrics that compute_tree_metrics can be asked for. The number of
+// vertices is always computed; Omega needs D and D_min, which are then
+// computed too.
+enum tree_metric_feature {
+   metric_K2 = 1,     // sum of squared degrees
+   metric_D = 2,      // sum of edge lengths
+   metric_D_min = 4,  // minimum sum of edge lengths (Shiloach's algorithm)
+   metric_C = 8,      // number of edge crossings
+   metric_Omega = 16, // (D_random - D)/(D_random - D_min)
+   all_tree_metrics = 31
+};
+
+// Metrics of a tree. Those that were not asked for are 0.
+struct tree_metrics {
+   int n;
+   int K2;
+   int D;
+   int D_min;
+   int C;
+   double D_random; // (n - 1)(n + 1)/3, the expected D of a random arrangement
+   double Omega;    // undefined (not a number) if n < 3
+};
+
+// Pre: t is a tree if metric_D_min or metric_Omega are in features
+// Post: the metrics in features of the tree, computed with a single sweep of the heads
+//       (and a counting sort of the edges for the crossings), with no adjacency structure
+tree_metrics compute_tree_metrics(const dependency_tree &t, unsigned features = all_tree_metrics);
+
+// Same as above, for the tree with those heads (see dependency_tree)
+tree_metrics compute_tree_metrics(const int *heads, int n, unsigned features = all_tree_metrics);
+
+// Same as above, for a tree already built as an undirected_graph
+tree_metrics compute_tree_metrics(const undirected_graph &g, unsigned features = all_tree_metrics);
+
+#endif
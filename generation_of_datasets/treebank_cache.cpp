@@ -0,0 +1,210 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "treebank_cache.hpp"
+
+static const char cache_magic[8] = { 'O', 'S', 'D', 'D', 'H', 'E', 'A', 'D' };
+static const uint32_t cache_version = 1;
+
+static size_t padded(size_t bytes) {
+   return (bytes + 7)/8*8;
+}
+
+// little-endian encoding, whatever the host
+static void put(vector<char> &out, uint64_t x, size_t bytes) {
+   for (size_t i = 0; i < bytes; ++i) out.push_back(char((x >> (8*i)) & 0xff));
+}
+
+static void put_varint(vector<char> &out, uint32_t x) {
+   while (x >= 128) {
+      out.push_back(char((x & 127) | 128));
+      x >>= 7;
+   }
+   out.push_back(char(x));
+}
+
+bool write_treebank_cache(const char *file_name, const string &treebank, const vector<int> &heads, const vector<size_t> &offset) {
+   assert(not offset.empty() and offset.back() == heads.size());
+   size_t trees = offset.size() - 1;
+   size_t max_length = 0;
+   for (size_t t = 0; t < trees; ++t) max_length = max(max_length, offset[t + 1] - offset[t]);
+   // the heads, and where every tree starts among them
+   vector<char> encoded;
+   vector<uint64_t> start(trees + 1, 0);
+   for (size_t t = 0; t < trees; ++t) {
+      for (size_t i = offset[t]; i < offset[t + 1]; ++i) {
+         assert(heads[i] >= 0);
+         put_varint(encoded, heads[i]);
+      }
+      start[t + 1] = encoded.size();
+   }
+   // counting sort of the trees by length, stable so that every length keeps the corpus order
+   vector<uint64_t> first(max_length + 2, 0);
+   for (size_t t = 0; t < trees; ++t) ++first[offset[t + 1] - offset[t] + 1];
+   for (size_t n = 0; n <= max_length; ++n) first[n + 1] += first[n];
+   vector<uint64_t> next(first.begin(), first.end() - 1);
+   vector<uint32_t> by_length(trees);
+   for (size_t t = 0; t < trees; ++t) by_length[next[offset[t + 1] - offset[t]]++] = t;
+
+   vector<char> out(cache_magic, cache_magic + 8);
+   put(out, cache_version, 4);
+   put(out, treebank.size(), 4);
+   out.insert(out.end(), treebank.begin(), treebank.end());
+   out.resize(padded(out.size()), 0);
+   put(out, trees, 8);
+   put(out, max_length, 8);
+   for (size_t t = 0; t <= trees; ++t) put(out, start[t], 8);
+   for (size_t t = 0; t < trees; ++t) put(out, offset[t + 1] - offset[t], 4);
+   out.resize(padded(out.size()), 0);
+   for (size_t n = 0; n < first.size(); ++n) put(out, first[n], 8);
+   for (size_t t = 0; t < trees; ++t) put(out, by_length[t], 4);
+   out.resize(padded(out.size()), 0);
+   out.insert(out.end(), encoded.begin(), encoded.end());
+   ofstream file(file_name, ios::binary);
+   file.write(out.data(), out.size());
+   return bool(file);
+}
+
+string treebank_id(const string &file_name) {
+   size_t begin = file_name.find_last_of("/\\");
+   begin = (begin == string::npos) ? 0 : begin + 1;
+   return file_name.substr(begin, file_name.find('.', begin) - begin);
+}
+
+treebank_cache::treebank_cache(const char *file_name) : fd(-1), data(NULL), length(0), tree_count(0), max_length(0),
+   offset(NULL), lengths(NULL), first(NULL), by_length(NULL), heads(NULL), next(0) {
+   assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+   fd = open(file_name, O_RDONLY);
+   if (fd < 0) return;
+   struct stat info;
+   void *p = MAP_FAILED;
+   if (fstat(fd, &info) == 0 and info.st_size >= 16) p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (p != MAP_FAILED) {
+      data = static_cast<const char *>(p);
+      length = info.st_size;
+   }
+   uint32_t version, id_length;
+   uint64_t trees, longest;
+   size_t position;
+   if (data == NULL or memcmp(data, cache_magic, 8) != 0) goto bad;
+   memcpy(&version, data + 8, 4);
+   memcpy(&id_length, data + 12, 4);
+   if (version != cache_version or 16 + size_t(id_length) + 16 > length) goto bad;
+   id = string(data + 16, id_length);
+   position = padded(16 + id_length);
+   memcpy(&trees, data + position, 8);
+   memcpy(&longest, data + position + 8, 8);
+   position += 16;
+   if (position + 8*(trees + 1) + 4*trees + 8*(longest + 2) + 4*trees > length) goto bad;
+   offset = reinterpret_cast<const uint64_t *>(data + position);
+   position += 8*(trees + 1);
+   lengths = reinterpret_cast<const uint32_t *>(data + position);
+   position = padded(position + 4*trees);
+   first = reinterpret_cast<const uint64_t *>(data + position);
+   position += 8*(longest + 2);
+   by_length = reinterpret_cast<const uint32_t *>(data + position);
+   position = padded(position + 4*trees);
+   heads = reinterpret_cast<const unsigned char *>(data + position);
+   if (position + offset[trees] > length) goto bad;
+   tree_count = trees;
+   max_length = longest;
+   madvise(p, length, MADV_SEQUENTIAL);
+   return;
+bad:
+   if (data != NULL) munmap(const_cast<char *>(data), length);
+   close(fd);
+   fd = -1;
+   data = NULL;
+}
+
+treebank_cache::~treebank_cache() {
+   if (data != NULL) munmap(const_cast<char *>(data), length);
+   if (fd >= 0) close(fd);
+}
+
+bool treebank_cache::good() const {
+   return fd >= 0;
+}
+
+const string &treebank_cache::treebank() const {
+   return id;
+}
+
+size_t treebank_cache::trees() const {
+   return tree_count;
+}
+
+size_t treebank_cache::tree_length(size_t t) const {
+   assert(t < tree_count);
+   return lengths[t];
+}
+
+void treebank_cache::read_tree(size_t t, vector<int> &h) const {
+   assert(t < tree_count);
+   const unsigned char *p = heads + offset[t];
+   const unsigned char *end = heads + offset[t + 1];
+   size_t n = h.size() + lengths[t];
+   h.reserve(n);
+   while (p != end) {
+      uint32_t x = 0;
+      int shift = 0;
+      while (*p >= 128) {
+         x |= uint32_t(*p++ & 127) << shift;
+         shift += 7;
+      }
+      x |= uint32_t(*p++) << shift;
+      h.push_back(x);
+   }
+   assert(h.size() == n);
+}
+
+bool treebank_cache::read_tree(vector<int> &h) {
+   if (next == tree_count) return false;
+   read_tree(next++, h);
+   return true;
+}
+
+void treebank_cache::read_trees(vector<int> &h, vector<size_t> &o) {
+   assert(o.empty() or o.back() == h.size());
+   if (o.empty()) o.push_back(h.size());
+   if (next < tree_count) h.reserve(h.size() + (offset[tree_count] - offset[next]));
+   while (read_tree(h)) o.push_back(h.size());
+}
+
+size_t treebank_cache::count(size_t min, size_t max) const {
+   if (min > max or min > max_length) return 0;
+   if (max > max_length) max = max_length;
+   return first[max + 1] - first[min];
+}
+
+const uint32_t *treebank_cache::trees_of_length(size_t min, size_t max) const {
+   if (min > max_length) return by_length + tree_count;
+   return by_length + first[min];
+}
@@ -0,0 +1,96 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _TREEBANK_CACHE_
+#define _TREEBANK_CACHE_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "heads_file.hpp"
+
+using namespace std;
+
+// Binary cache of the trees of a .heads file, so that they are not parsed
+// again in every run. All numbers are little-endian:
+//   "OSDDHEAD", version (uint32), length of the treebank id (uint32) and its
+//   characters, padded to a multiple of 8 bytes;
+//   trees (uint64), maximum length (uint64);
+//   offset (uint64[trees + 1]): tree t is encoded in bytes offset[t], ..., offset[t+1]-1 of the heads;
+//   length (uint32[trees], padded): the number of vertices of every tree;
+//   first (uint64[maximum length + 2]) and by_length (uint32[trees], padded): the trees of
+//     length n are by_length[first[n]], ..., by_length[first[n+1]-1], in corpus order;
+//   heads: the heads of every tree, one LEB128 varint each (one byte if below 128).
+// The trees are kept in corpus order; by_length is an index to jump to the trees of any length.
+
+/**
+ * A treebank cache mapped in memory. The trees can be read one after the
+ * other, as those of a heads_file, or directly by their number.
+ */
+class treebank_cache : public heads_source {
+private:
+   int fd;
+   const char *data;
+   size_t length;
+   string id;
+   size_t tree_count;
+   size_t max_length;
+   const uint64_t *offset;
+   const uint32_t *lengths;
+   const uint64_t *first;
+   const uint32_t *by_length;
+   const unsigned char *heads;
+   size_t next; // first tree not read yet
+   treebank_cache(const treebank_cache &);
+   treebank_cache &operator=(const treebank_cache &);
+public:
+   treebank_cache(const char *file_name);
+   ~treebank_cache();
+   // Post: false if the file could not be opened or is not a treebank cache
+   bool good() const;
+   bool read_tree(vector<int> &heads);
+   void read_trees(vector<int> &heads, vector<size_t> &offset);
+   // the treebank id given when the cache was written
+   const string &treebank() const;
+   size_t trees() const;
+   // Pre: t < trees()
+   size_t tree_length(size_t t) const;
+   // Post: the heads of tree t have been appended to heads
+   void read_tree(size_t t, vector<int> &heads) const;
+   // Post: the number of trees whose length is in [min, max]
+   size_t count(size_t min, size_t max) const;
+   // Post: the trees whose length is in [min, max], by length and then in corpus order,
+   // are trees_of_length(min, max)[0], ..., trees_of_length(min, max)[count(min, max) - 1]
+   const uint32_t *trees_of_length(size_t min, size_t max) const;
+};
+
+// Post: the trees of heads and offset (as filled by heads_source::read_trees)
+// have been written to file_name, false if it could not be written
+bool write_treebank_cache(const char *file_name, const string &treebank, const vector<int> &heads, const vector<size_t> &offset);
+
+// Post: the name of a file without its directory and its extensions,
+// used as the treebank id of the cache of a .heads file
+string treebank_id(const string &file_name);
+
+#endif
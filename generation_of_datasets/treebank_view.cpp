@@ -0,0 +1,71 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#include <algorithm>
+#include "treebank_view.hpp"
+
+treebank_view::treebank_view() : graphs(NULL), whole(false) {
+}
+
+treebank_view::treebank_view(const vector<undirected_graph> &graphs) : graphs(&graphs), whole(true) {
+}
+
+treebank_view::treebank_view(const vector<undirected_graph> &graphs, const vector<int> &index) : graphs(&graphs), index(index), whole(false) {
+}
+
+const vector<undirected_graph> &treebank_view::treebank() const {
+   assert(graphs != NULL);
+   return *graphs;
+}
+
+length_index::length_index(const treebank_view &view) : graphs(&view.treebank()) {
+   int max_length = 0;
+   for (size_t i = 0; i < view.size(); ++i) max_length = max(max_length, view[i].vertices());
+   first = vector<int>(max_length + 2, 0);
+   for (size_t i = 0; i < view.size(); ++i) ++first[view[i].vertices() + 1];
+   for (int n = 1; n <= max_length + 1; ++n) first[n] += first[n - 1];
+   by_length = vector<int>(view.size());
+   vector<int> next(first);
+   for (size_t i = 0; i < view.size(); ++i) by_length[next[view[i].vertices()]++] = view.position(i);
+}
+
+size_t length_index::count(int min_length, int max_length) const {
+// Post: number of graphs with at least min_length and at most max_length vertices
+   int last = int(first.size()) - 1;
+   min_length = min(max(min_length, 0), last);
+   max_length = min(max_length + 1, last);
+   if (max_length <= min_length) return 0;
+   return first[max_length] - first[min_length];
+}
+
+treebank_view length_index::group(int min_length, int max_length) const {
+// Post: the graphs counted by count(min_length, max_length), in treebank order
+   int last = int(first.size()) - 1;
+   min_length = min(max(min_length, 0), last);
+   max_length = min(max_length + 1, last);
+   if (max_length <= min_length) return treebank_view(*graphs, vector<int>());
+   vector<int> positions(by_length.begin() + first[min_length], by_length.begin() + first[max_length]);
+   sort(positions.begin(), positions.end());
+   return treebank_view(*graphs, positions);
+}
+
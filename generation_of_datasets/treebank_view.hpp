@@ -0,0 +1,85 @@
+/*********************************************************************
+ *
+ * Optimality Syntactic Dependency Distances
+ *
+ * Copyright (C) 2020
+ *
+ * This file is part of Optimality Syntactic Dependency Distances.
+ *
+ * Optimality Syntactic Dependency Distances is free software: you can redistribute
+ * it and/or modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Optimality Syntactic Dependency Distances is distributed in the hope that
+ * it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Linear Arrangement Library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ********************************************************************/
+
+#ifndef _TREEBANK_VIEW_
+#define _TREEBANK_VIEW_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "undirected_graph.hpp"
+
+using namespace std;
+
+/**
+ * Read-only view of some of the graphs of a treebank, given by their
+ * positions in the vector that owns them. Graphs are never copied, so
+ * the vector must outlive every view of it.
+ */
+class treebank_view {
+private:
+   const vector<undirected_graph> *graphs;
+   vector<int> index; // positions in *graphs, unused if whole
+   bool whole;
+public:
+   treebank_view();
+   treebank_view(const vector<undirected_graph> &graphs);
+   treebank_view(const vector<undirected_graph> &graphs, const vector<int> &index);
+   size_t size() const;
+   const undirected_graph &operator[](size_t i) const;
+   int position(size_t i) const;
+   // Pre: the view has not been built with the default constructor
+   const vector<undirected_graph> &treebank() const;
+};
+
+/**
+ * Graphs of a view bucketed by their number of vertices, so that the
+ * graphs with length in any interval are found without scanning the view.
+ */
+class length_index {
+private:
+   const vector<undirected_graph> *graphs;
+   vector<int> first; // first[n]: number of graphs with less than n vertices
+   vector<int> by_length; // positions in *graphs sorted by length
+public:
+   // Pre: the view has not been built with the default constructor
+   length_index(const treebank_view &view);
+   size_t count(int min_length, int max_length) const;
+   treebank_view group(int min_length, int max_length) const;
+};
+
+inline size_t treebank_view::size() const {
+   return whole ? graphs->size() : index.size();
+}
+
+inline const undirected_graph &treebank_view::operator[](size_t i) const {
+   return (*graphs)[position(i)];
+}
+
+inline int treebank_view::position(size_t i) const {
+// Post: position in the treebank of the i-th graph of the view
+   assert(i < size());
+   return whole ? int(i) : index[i];
+}
+
+#endif
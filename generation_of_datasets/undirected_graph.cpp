@@ -33,9 +33,11 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include "undirected_graph.hpp"
 // #include "shiloach.hh"
 #include "common.hpp"
+#include "scratch_arena.hpp"
 
 void connected_components(const undirected_graph &g, int c, int start, int &vertices, vector<int> &color, vector<int> &new_vertex);
 undirected_graph read_edges_from_ifstream(int vertices, int edges, ifstream &in);
@@ -52,12 +54,14 @@ int sum_of_edge_lengths_lower_bound(int degree) {
 }
 
 undirected_graph scrambled_graph(const undirected_graph &g, const permutation &p) {
-   undirected_graph g_scrambled(g.vertices());
+   edge_list scrambled_edges;
+   scrambled_edges.reserve(g.edges());
    for (int v = 0; v < int(g.vertices()); ++v) {
-       for (set<int>::const_iterator j = g.adjacent[v].begin();  j != g.adjacent[v].end(); ++j) {
-           if (v < *j) g_scrambled.add_edge(p[v],p[*j]);
+       for (neighbourhood::const_iterator j = g.adjacent[v].begin();  j != g.adjacent[v].end(); ++j) {
+           if (v < *j) scrambled_edges.push_back(pair<int, int>(p[v],p[*j]));
        }
    }
+   undirected_graph g_scrambled(g.vertices(), scrambled_edges);
    assert(g.edges() == g_scrambled.edges());
    return g_scrambled;
 }
@@ -65,7 +69,7 @@ undirected_graph scrambled_graph(const undirected_graph &g, const permutation &p
 vector<undirected_graph> get_connected_components(const undirected_graph &g) {
    vector<int> color(g.vertices(),-1);
    vector<int> new_vertex(g.vertices(),-1);
-   vector<undirected_graph> cc(0);
+   vector<int> cc_vertices(0);
    int total_vertices = 0;
    int c = 0;
    for (int v = 0; v < g.vertices(); ++v) {
@@ -73,19 +77,24 @@ vector<undirected_graph> get_connected_components(const undirected_graph &g) {
          int vertices = 0;
          connected_components(g,c,v,vertices, color, new_vertex);
          assert(vertices >= 1);
-         undirected_graph g(vertices);
-         cc.push_back(g);
+         cc_vertices.push_back(vertices);
          total_vertices += vertices;
          ++c;
       }
    }
+   vector<edge_list> cc_edges(c);
    for (int v = 0; v < g.vertices(); ++v) {
-      for (set<int>::const_iterator i = g.adjacent[v].begin(); i != g.adjacent[v].end(); ++i) {
+      for (neighbourhood::const_iterator i = g.adjacent[v].begin(); i != g.adjacent[v].end(); ++i) {
           assert(color[v] == color[*i]);
-          if (v < *i) cc[color[v]].add_edge(new_vertex[v],new_vertex[*i]);
+          if (v < *i) cc_edges[color[v]].push_back(pair<int, int>(new_vertex[v],new_vertex[*i]));
       }
    }
    assert(total_vertices == g.vertices());
+   vector<undirected_graph> cc(0);
+   cc.reserve(c);
+   for (int i = 0; i < c; ++i) {
+      cc.push_back(undirected_graph(cc_vertices[i], cc_edges[i]));
+   }
    return cc;
 }
 
@@ -93,7 +102,7 @@ void connected_components(const undirected_graph &g, int c, int start, int &vert
    new_vertex[start] = vertices;
    ++vertices;
    color[start] = c;
-   for (set<int>::const_iterator i = g.adjacent[start].begin(); i != g.adjacent[start].end(); ++i) {
+   for (neighbourhood::const_iterator i = g.adjacent[start].begin(); i != g.adjacent[start].end(); ++i) {
      if (color[*i] < 0) {
         connected_components(g,c,*i, vertices, color, new_vertex);
      } 
@@ -125,7 +134,7 @@ undirected_graph read_tree_from_ifstream(ifstream &in) {
 }
 
 undirected_graph read_edges_from_ifstream(int vertices, int edges, ifstream &in) {
-   undirected_graph g(vertices);
+   edge_list l;
    int u, v;
    for (int i = 0; i < edges; ++i) {
       assert(in >> u >> v);
@@ -134,8 +143,9 @@ undirected_graph read_edges_from_ifstream(int vertices, int edges, ifstream &in)
       assert(u < vertices);
       assert(0 <= v);
       assert(v < vertices);
-      g.add_edge(u,v);     
+      l.push_back(pair<int, int>(u,v));     
    }
+   undirected_graph g(vertices, l);
 /*   if (edges != g.edges()) {
       cout << "           **** " << vertices << " " << edges << " " << g.edges() << endl;
    } */
@@ -171,27 +181,145 @@ void write_tree_on_ofstream(const undirected_graph &g, ofstream &out) {
 
 void write_edges_on_ofstream(const undirected_graph &g, ofstream &out) {
    for (int u = 0; u < g.vertices(); ++u) {
-       for (set<int>::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
+       for (neighbourhood::const_iterator i = g.adjacent[u].begin(); i != g.adjacent[u].end(); ++i) {
            if (u < *i) out << u << " " << *i << endl;
        }
    }
 }
 
+neighbourhood::const_iterator neighbourhood::find(int v) const {
+   const_iterator i = lower_bound(first, last, v);
+   if (i != last and *i == v) return i;
+   return last;
+}
+
+compressed_adjacency::compressed_adjacency(): offset(1, 0) {
+}
+
+compressed_adjacency::compressed_adjacency(int vertices): offset(vertices + 1, 0) {
+   assert(0 <= vertices);
+}
+
+void compressed_adjacency::insert(int u, int v) {
+   // Pre: v is not a neighbour of u
+   vector<int>::iterator first = neighbour.begin() + offset[u];
+   vector<int>::iterator last = neighbour.begin() + offset[u + 1];
+   vector<int>::iterator i = lower_bound(first, last, v);
+   assert(i == last or *i != v);
+   neighbour.insert(i, v);
+   for (int w = u + 1; w < int(offset.size()); ++w) {
+       ++offset[w];
+   }
+   // Post: v is a neighbour of u. The cost is O(V + E), so graphs with many edges 
+   //       should be built with the constructors of undirected_graph that take all the edges at once
+}
+
+void compressed_adjacency::clear(int v) {
+   int k = offset[v + 1] - offset[v];
+   neighbour.erase(neighbour.begin() + offset[v], neighbour.begin() + offset[v + 1]);
+   for (int w = v + 1; w < int(offset.size()); ++w) {
+       offset[w] -= k;
+   }
+}
+
+void compressed_adjacency::clear() {
+   fill(offset.begin(), offset.end(), 0);
+   neighbour.clear();
+}
+
 undirected_graph::undirected_graph() {
    V=E=0;
 }
 
-undirected_graph::undirected_graph(int vertices) {
+undirected_graph::undirected_graph(int vertices): adjacent(vertices) {
    assert(0 <= vertices);
    V = vertices;
    E = 0;
-   adjacent = vector<set<int> >(V);
+}
+
+undirected_graph::undirected_graph(int vertices, const edge_list &edges): adjacent(vertices) {
+   assert(0 <= vertices);
+   V = vertices;
+   E = edges.size();
+   vector<int> &offset = adjacent.offset;
+   vector<int> &neighbour = adjacent.neighbour;
+   for (int e = 0; e < E; ++e) {
+       int u = edges[e].first;
+       int v = edges[e].second;
+       assert(0 <= u and u < V);
+       assert(0 <= v and v < V);
+       assert(u != v);
+       ++offset[u + 1];
+       ++offset[v + 1];
+   }
+   for (int v = 0; v < V; ++v) {
+       offset[v + 1] += offset[v];
+   }
+   neighbour = vector<int>(2*E);
+   vector<int> next(offset.begin(), offset.end() - 1);
+   for (int e = 0; e < E; ++e) {
+       int u = edges[e].first;
+       int v = edges[e].second;
+       neighbour[next[u]++] = v;
+       neighbour[next[v]++] = u;
+   }
+   for (int v = 0; v < V; ++v) {
+       sort(neighbour.begin() + offset[v], neighbour.begin() + offset[v + 1]);
+       // no edge appears twice
+       assert(adjacent_find(neighbour.begin() + offset[v], neighbour.begin() + offset[v + 1]) == neighbour.begin() + offset[v + 1]);
+   }
+}
+
+undirected_graph::undirected_graph(const vector<int> &heads): undirected_graph(heads.data(), heads.size()) {
+}
+
+undirected_graph::undirected_graph(const int *heads, int n): adjacent(n) {
+   // Pre: heads[v] is the position (starting at 1) of the head of v, or 0 if v is the root, 0 <= v < n
+   V = n;
+   E = 0;
+   vector<int> &offset = adjacent.offset;
+   vector<int> &neighbour = adjacent.neighbour;
+   for (int v = 0; v < V; ++v) {
+       int head = heads[v] - 1;
+       if (head >= 0) {
+          assert(head < V);
+          assert(head != v);
+          ++offset[v + 1];
+          ++offset[head + 1];
+          ++E;
+       }
+   }
+   for (int v = 0; v < V; ++v) {
+       offset[v + 1] += offset[v];
+   }
+   neighbour = vector<int>(2*E);
+   // the dependents of every vertex, in increasing order, at the beginning of its slice
+   vector<int> next(offset.begin(), offset.end() - 1);
+   for (int v = 0; v < V; ++v) {
+       int head = heads[v] - 1;
+       if (head >= 0) neighbour[next[head]++] = v;
+   }
+   // the head of every vertex, moved from the end of its slice to its place among the dependents
+   for (int v = 0; v < V; ++v) {
+       int head = heads[v] - 1;
+       if (head >= 0) {
+          int k = offset[v + 1] - 1;
+          assert(next[v] == k);
+          while (k > offset[v] and neighbour[k - 1] > head) {
+              neighbour[k] = neighbour[k - 1];
+              --k;
+          }
+          assert(k == offset[v] or neighbour[k - 1] != head);
+          neighbour[k] = head;
+       }
+   }
+   // Post: the edges are those between every vertex and its head
 }
 
 void undirected_graph::add_edge(int u, int v) {
    assert(not edge(u, v));
-   adjacent[u].insert(v);
-   adjacent[v].insert(u);
+   adjacent.insert(u, v);
+   adjacent.insert(v, u);
    ++E;
 }
 
@@ -199,7 +327,7 @@ void undirected_graph::remove_edges_of_vertices(const vector<int> &v, int n) {
    int sum = 0;
    for (int i = 0; i < n; ++i) {
        sum += degree(v[i]);
-       adjacent[v[i]].clear();
+       adjacent.clear(v[i]);
    }
    assert(sum % 2 == 0);
    E -= sum/2;
@@ -207,9 +335,7 @@ void undirected_graph::remove_edges_of_vertices(const vector<int> &v, int n) {
 }
 
 void undirected_graph::empty_edges() {
-   for (int v = 0; v < int(adjacent.size()); ++v) {
-       adjacent[v].clear(); 
-   }
+   adjacent.clear();
    E = 0;
 }
 
@@ -276,7 +402,7 @@ void undirected_graph::depth_first_search(int v, vector<bool> &visited, int &vis
    assert(not visited[v]);
    visited[v]=true;
    ++visits;
-   for (set<int>::const_iterator i = adjacent[v].begin(); i!=adjacent[v].end(); ++i) {
+   for (neighbourhood::const_iterator i = adjacent[v].begin(); i!=adjacent[v].end(); ++i) {
        if (not visited[*i]) depth_first_search(*i, visited, visits);
    }
 }
@@ -288,7 +414,7 @@ bool undirected_graph::tree() const {
 int undirected_graph::edge_length_sum() const {
    int sum = 0;
    for (int i = 0; i<int(adjacent.size()); ++i) {
-      for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end() and *j < i; ++j) {
+      for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end() and *j < i; ++j) {
           int d = i - *j;
           assert(d > 0);
           sum += d;
@@ -300,9 +426,11 @@ int undirected_graph::edge_length_sum() const {
 
 int undirected_graph::minimum_edge_length_sum_of_a_tree() const {
    assert(tree());
-   list<pair<uint32_t, uint32_t> > l;
+   scratch_scope scope;
+   edge_vector l(&tree_scratch());
+   l.reserve(edges());
    for (int i = 0; i<int(adjacent.size()); ++i) {
-      for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end() and *j < i; ++j) {
+      for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end() and *j < i; ++j) {
           l.push_back(pair<uint32_t, uint32_t>(i+1, *j+1));
       }
    } 
@@ -314,7 +442,7 @@ int undirected_graph::minimum_edge_length_sum_of_a_tree() const {
 void undirected_graph::edge_length_statistics(double &mean_length, double &mean_length2, double &variance_length) const {
    mean_length = mean_length2 = 0;
    for (int i = 0; i<int(adjacent.size()); ++i) {
-      for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
+      for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
           if (i <= *j) {
              int length = abs(i - *j);   
              mean_length += length;
@@ -330,7 +458,7 @@ void undirected_graph::edge_length_statistics(double &mean_length, double &mean_
 vector<int> undirected_graph::edge_length_spectrum() const {
    vector<int> spectrum(vertices(),0);
    for (int i = 0; i<int(adjacent.size()); ++i) {
-      for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
+      for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
           if (i <= *j) {
              int length = abs(i - *j);
              ++spectrum[length];
@@ -347,11 +475,11 @@ int undirected_graph::crossings() const {
    int crossings = 0;  
    if (vertices() >= 4) {
       for (int i = 0; i<int(adjacent.size()); ++i) {
-         for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
+         for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
              int inc = *j - i; 
              if (inc >= 0 and inc != 1 and i != vertices() - 1) {
                 for (int k = i + 1; k < *j; ++k) {
-                    for (set<int>::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
+                    for (neighbourhood::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
                         if (k <= *l) {
                            bool cross = *l < i or *l > *j;
                            crossings += cross;
@@ -371,17 +499,18 @@ int undirected_graph::crossings() const {
    return crossings_lazy(edges()*edges());
 }
 
+/*
 int undirected_graph::crossings_lazy(int crossings_min) const {
    int crossings = 0;  
    if (vertices() >= 4) {
       for (int i = 0; i<int(adjacent.size()); ++i) {
-         for (set<int>::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
+         for (neighbourhood::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
              int inc = *j - i;
              assert(inc >= 0); 
              if (inc > 1 and i != vertices() - 1) {
                 for (int k = i + 1; k < *j; ++k) {
-//                    for (set<int>::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
-                    for (set<int>::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend() and *l > k; ++l) {
+//                    for (neighbourhood::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
+                    for (neighbourhood::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend() and *l > k; ++l) {
                         assert(k <= *l);
 //                        if (k <= *l) {
                            bool cross = *l < i or *l > *j;
@@ -399,6 +528,37 @@ int undirected_graph::crossings_lazy(int crossings_min) const {
    //       if crossings > crossings_min then crossings > crossings_min
    return crossings;
 }
+*/
+
+int undirected_graph::crossings_lazy(int crossings_min) const {
+   // The edges are visited by increasing left endpoint. An edge (i, j), i < j, crosses an edge (k, l), k < l, 
+   // with k < i iff i < l < j, so the right endpoints of the edges already visited are kept in a Fenwick tree  
+   // and the crossings of (i, j) are the right endpoints that lie strictly between i and j. The edges with  
+   // left endpoint i share a vertex, so they are added to the tree after all of them have been counted.
+   int crossings = 0;  
+   if (vertices() >= 4) {
+      int n = vertices();
+      vector<int> right_endpoints(n + 1, 0); // Fenwick tree: vertex v is at position v + 1
+      for (int i = 0; i < n; ++i) {
+         neighbourhood N = adjacent[i];
+         for (neighbourhood::const_reverse_iterator j = N.rbegin(); j != N.rend() and *j > i; ++j) {
+             assert(*j - i >= 1);
+             // right endpoints in (i, *j) = right endpoints <= *j - 1 minus right endpoints <= i
+             for (int x = *j; x > 0; x -= x & -x) crossings += right_endpoints[x];
+             for (int x = i + 1; x > 0; x -= x & -x) crossings -= right_endpoints[x];
+             if (crossings > crossings_min) return crossings;
+         }
+         for (neighbourhood::const_reverse_iterator j = N.rbegin(); j != N.rend() and *j > i; ++j) {
+             for (int x = *j + 1; x <= n; x += x & -x) ++right_endpoints[x];
+         }
+      }
+      assert(crossings <= edges()*(edges()-1)/2);
+   } 
+   // Post: if crossings <= crossings_min then crossings is the number of edge of crossings; 
+   //       if crossings > crossings_min then crossings > crossings_min
+   //       The cost is O(m log n) with m the number of edges
+   return crossings;
+}
 
 int undirected_graph::crossings_with_edge(int i, int j) const {
    return crossings_with_edge_lazy(i, j, edges() + 1);
@@ -411,7 +571,7 @@ int undirected_graph::crossings_with_edge_lazy(int i, int j, int crossings_max)
     int crossings = 0;
     if (j - i < vertices() - 1) {
        for (int k = i + 1; k < j; ++k) {
-           for (set<int>::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend(); ++l) { 
+           for (neighbourhood::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend(); ++l) { 
               bool cross = *l < i or *l > j;
               crossings += cross;
               if (crossings > crossings_max) return crossings; 
@@ -427,7 +587,7 @@ double undirected_graph::predicted_crossings() const {
    double crossings = 0;
    if (vertices() >= 4) { 
       for (int i = 0; i<int(adjacent.size()); ++i) {
-         for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
+         for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
              int d = abs(i - *j);
              assert(1 <= d);
              assert(d <= vertices());
@@ -451,7 +611,7 @@ double undirected_graph::predicted_crossings() const {
    double crossings = 0;
    if (vertices() >= 4) {
       for (int i = 0; i<int(adjacent.size()); ++i) {
-         for (set<int>::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
+         for (neighbourhood::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
              int d = *j - i; 
              assert(d > 0);
              assert(d <= vertices() - 1);
@@ -478,13 +638,13 @@ double undirected_graph::fully_predicted_crossings(const probability_of_crossing
    double crossings = 0;
    if (vertices() >= 4) { 
       for (int i = 0; i<int(adjacent.size()); ++i) {
-         for (set<int>::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
+         for (neighbourhood::const_iterator j = adjacent[i].begin(); j != adjacent[i].end(); ++j) {
              int d1 = *j - i;
              if (d1 > 1 and d1 < d_max) {  
                 for (int k = 0; k < int(adjacent.size()); ++k) {
                     if (k != i and k != *j) {
 //                    if (k < i or (k == i and k < *j)) {
-                       for (set<int>::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
+                       for (neighbourhood::const_iterator l = adjacent[k].begin(); l != adjacent[k].end(); ++l) {
                            int d2 = *l - k;
                            if (d2 > 1 and *l != i and *l != *j) {
                               assert(d2 <= d_max);
@@ -516,7 +676,7 @@ double undirected_graph::fully_predicted_crossings(const probability_of_crossing
    potential_crossings = 0;
    if (vertices() >= 4) { 
       for (int i = 0; i < n; ++i) {
-         for (set<int>::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
+         for (neighbourhood::const_reverse_iterator j = adjacent[i].rbegin(); j != adjacent[i].rend() and *j > i; ++j) {
              int d1 = *j - i;
              assert(d1 > 0); 
              if (d1 > 1 and d1 < d_max) {  
@@ -524,7 +684,7 @@ double undirected_graph::fully_predicted_crossings(const probability_of_crossing
                   for (int k = i + 1; k < n; ++k) {
                     if (k != i and k != *j) {
                        assert(k != i and k != *j);
-                       for (set<int>::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend() and *l > k; ++l) {
+                       for (neighbourhood::const_reverse_iterator l = adjacent[k].rbegin(); l != adjacent[k].rend() and *l > k; ++l) {
                            int d2 = *l - k;
                            assert(d2 > 0);
                            if (d2 > 1 and d2 < d_max and *l != i and *l != *j) {
@@ -544,6 +704,70 @@ double undirected_graph::fully_predicted_crossings(const probability_of_crossing
    return crossings;
 }
 
+double undirected_graph::fully_predicted_crossings_by_length(const probability_of_crossing_knowing_edge_lengths &c) const {
+   int potential_crossings;
+   return fully_predicted_crossings_by_length(c, potential_crossings);
+}
+
+double undirected_graph::fully_predicted_crossings_by_length(const probability_of_crossing_knowing_edge_lengths &c, int &potential_crossings) const {
+   // Same as fully_predicted_crossings but the pairs of edges are grouped by their lengths: the number of pairs 
+   // of lengths d1 and d2 follows from the edge length spectrum, minus the pairs that share a vertex, which are 
+   // found at the vertex they share. The cost is O(L^2 + K2), with L the number of distinct edge lengths and 
+   // K2 the sum of squared degrees, instead of O(m^2).
+   int n = vertices();
+   assert(c.vertices() == n);
+   int d_max = n - 1;
+   double crossings = 0;
+   potential_crossings = 0;
+   if (vertices() >= 4) {
+      vector<int> spectrum = edge_length_spectrum();
+      // the lengths d that can produce a crossing (1 < d < d_max) and their index in pairs
+      vector<int> length;
+      vector<int> index(n, -1);
+      for (int d = 2; d < d_max; ++d) {
+          if (spectrum[d] > 0) {
+             index[d] = length.size();
+             length.push_back(d);
+          }
+      }
+      int L = length.size();
+      // pairs[a*L + b], a <= b, is the number of pairs of edges that do not share a vertex, of lengths length[a] and length[b]
+      vector<int> pairs(L*L, 0);
+      for (int a = 0; a < L; ++a) {
+          int ka = spectrum[length[a]];
+          pairs[a*L + a] = ka*(ka - 1)/2;
+          for (int b = a + 1; b < L; ++b) {
+              pairs[a*L + b] = ka*spectrum[length[b]];
+          }
+      }
+      for (int v = 0; v < n; ++v) {
+          neighbourhood N = adjacent[v];
+          for (neighbourhood::const_iterator j = N.begin(); j != N.end(); ++j) {
+              int a = index[abs(v - *j)];
+              if (a < 0) continue;
+              for (neighbourhood::const_iterator k = j + 1; k != N.end(); ++k) {
+                  int b = index[abs(v - *k)];
+                  if (b < 0) continue;
+                  if (a <= b) --pairs[a*L + b];
+                  else --pairs[b*L + a];
+              }
+          }
+      }
+      for (int a = 0; a < L; ++a) {
+          for (int b = a; b < L; ++b) {
+              int k = pairs[a*L + b];
+              assert(k >= 0);
+              if (k > 0) {
+                 potential_crossings += k;
+                 crossings += k*c.probability_of_crossing(length[a], length[b]);
+              }
+          }
+      }
+   }
+   assert(crossings >= 0);
+   return crossings;
+}
+
 double undirected_graph::mean_edge_length() const {
    double mean = edge_length_sum()/double(edges());
    assert(mean >= 1);
@@ -33,13 +33,51 @@
 #define _UNDIRECTED_GRAPH_
 
 #include <vector>
-#include <set>
+#include <iterator>
+#include <utility>
 #include <fstream>
 #include "permutation.hpp"
 #include "probability_of_crossing_knowing_edge_lengths.hpp"
 
 using namespace std;
 
+typedef vector<pair<int, int> > edge_list;
+
+// The neighbours of a vertex: a contiguous slice, in increasing order, of the
+// neighbour array of a compressed_adjacency.
+class neighbourhood {
+private:
+   const int *first;
+   const int *last;
+public:
+   typedef const int *const_iterator;
+   typedef std::reverse_iterator<const int *> const_reverse_iterator;
+   neighbourhood(const int *first, const int *last);
+   const_iterator begin() const;
+   const_iterator end() const;
+   const_reverse_iterator rbegin() const;
+   const_reverse_iterator rend() const;
+   const_iterator find(int v) const;
+   int size() const;
+};
+
+// Compressed sparse row adjacency: the neighbours of vertex v are
+// neighbour[offset[v]], ..., neighbour[offset[v + 1] - 1], in increasing order.
+class compressed_adjacency {
+private:
+   vector<int> offset;
+   vector<int> neighbour;
+   friend class undirected_graph;
+public:
+   compressed_adjacency();
+   compressed_adjacency(int vertices);
+   neighbourhood operator[](int v) const;
+   int size() const;
+   void insert(int u, int v);
+   void clear(int v);
+   void clear();
+};
+
 class undirected_graph {
 private:
    int V; // number of vertices
@@ -47,9 +85,12 @@ private:
 
    void depth_first_search(int v, vector<bool> &visited, int &visits) const;
 public:
-   vector<set<int> > adjacent;
+   compressed_adjacency adjacent;
    undirected_graph();
    undirected_graph(int vertices);
+   undirected_graph(int vertices, const edge_list &edges);
+   undirected_graph(const vector<int> &heads);
+   undirected_graph(const int *heads, int n);
    void add_edge(int u, int v);
    void empty_edges();
    void remove_edges_of_vertices(const vector<int> &v, int n);
@@ -69,6 +110,8 @@ public:
    double predicted_crossings() const;
    double fully_predicted_crossings(const probability_of_crossing_knowing_edge_lengths &c) const;
    double fully_predicted_crossings(const probability_of_crossing_knowing_edge_lengths &c, int &potential_crossings) const;
+   double fully_predicted_crossings_by_length(const probability_of_crossing_knowing_edge_lengths &c) const;
+   double fully_predicted_crossings_by_length(const probability_of_crossing_knowing_edge_lengths &c, int &potential_crossings) const;
    void edge_length_statistics(double &mean_length, double &mean_length2, double &variance_length) const;
    vector<int> edge_length_spectrum() const;
    int edge_length_sum() const;
@@ -78,6 +121,38 @@ public:
    double mean_edge_length_lower_bound() const;
 };
 
+inline neighbourhood::neighbourhood(const int *first, const int *last): first(first), last(last) {
+}
+
+inline neighbourhood::const_iterator neighbourhood::begin() const {
+   return first;
+}
+
+inline neighbourhood::const_iterator neighbourhood::end() const {
+   return last;
+}
+
+inline neighbourhood::const_reverse_iterator neighbourhood::rbegin() const {
+   return const_reverse_iterator(last);
+}
+
+inline neighbourhood::const_reverse_iterator neighbourhood::rend() const {
+   return const_reverse_iterator(first);
+}
+
+inline int neighbourhood::size() const {
+   return last - first;
+}
+
+inline neighbourhood compressed_adjacency::operator[](int v) const {
+   const int *base = neighbour.data();
+   return neighbourhood(base + offset[v], base + offset[v + 1]);
+}
+
+inline int compressed_adjacency::size() const {
+   return int(offset.size()) - 1;
+}
+
 int sum_of_edge_lengths_lower_bound(int degree);
 undirected_graph scrambled_graph(const undirected_graph &g, const permutation &p);
 vector<undirected_graph> get_connected_components(const undirected_graph &g);
@@ -288,3 +288,31 @@ ftree all_ulab_free_trees::get_tree() const {
 	return level_sequence_to_tree(m_L, m_n);
 }
 
+
+void all_ulab_free_trees::write_state(ostream& os) const {
+	os << m_n << " " << m_is_last << " " << m_first_it << " "
+	   << m_p << " " << m_q << " " << m_h1 << " " << m_h2 << " "
+	   << m_c << " " << m_r;
+	for (uint32_t i = 0; i <= m_n; ++i) { os << " " << m_L[i]; }
+	for (uint32_t i = 0; i <= m_n; ++i) { os << " " << m_W[i]; }
+	os << endl;
+}
+
+bool all_ulab_free_trees::read_state(istream& is) {
+	if (not (is >> m_n >> m_is_last >> m_first_it
+				>> m_p >> m_q >> m_h1 >> m_h2 >> m_c >> m_r))
+	{
+		return false;
+	}
+	m_L = vector<uint32_t>(m_n+1, 0);
+	m_W = vector<uint32_t>(m_n+1, 0);
+	for (uint32_t i = 0; i <= m_n; ++i) { is >> m_L[i]; }
+	for (uint32_t i = 0; i <= m_n; ++i) { is >> m_W[i]; }
+	if (not is) { return false; }
+
+	// the levels and the subscripts of the parents are at most n
+	for (uint32_t i = 0; i <= m_n; ++i) {
+		if (m_L[i] > m_n or m_W[i] > m_n) { return false; }
+	}
+	return true;
+}
@@ -33,6 +33,7 @@
 
 // C++ includes
 #include <cinttypes>
+#include <iostream>
 #include <vector>
 
 // lal includes
@@ -128,6 +129,25 @@ class all_ulab_free_trees {
 		 */
 		ftree get_tree() const;
 
+		/**
+		 * @brief Writes the internal state of the generator.
+		 *
+		 * The state is written in a single line of text, and
+		 * it can be restored with @ref read_state so that the
+		 * generation continues after the last tree generated.
+		 * @param os Output stream.
+		 */
+		void write_state(std::ostream& os) const;
+
+		/**
+		 * @brief Restores a state written with @ref write_state.
+		 * @param is Input stream.
+		 * @return Returns false if the state could not be read
+		 * or is not valid. The generator must be initialised again
+		 * in that case.
+		 */
+		bool read_state(std::istream& is);
+
 	private:
 		/// Canonical level sequence of the tree.
 		std::vector<uint32_t> m_L;
@@ -138,30 +158,30 @@ class all_ulab_free_trees {
 		std::vector<uint32_t> m_W;
 
 		/// Largest integer such that \f$l_p \neq 2\f$.
-		uint32_t m_p;
+		uint32_t m_p = 0;
 		/// Largest integer such that \f$q < p, \; l_q = l_p - 1\f$.
-		uint32_t m_q;
+		uint32_t m_q = 0;
 
 		/// Maximum level number in the first principal subsequence.
-		uint32_t m_h1;
+		uint32_t m_h1 = 0;
 		/// Maximum level number in the second principal subsequence.
-		uint32_t m_h2;
+		uint32_t m_h2 = 0;
 
 		/**
 		 * @brief An index to the first element of \f$L_2\f$.
 		 *
 		 * \f$L_2\f$ is the second principal subsequence of \f$L\f$.
 		 */
-		uint32_t m_c;
+		uint32_t m_c = 0;
 		/**
 		 * @brief Exactly \f$m - 1\f$.
 		 *
 		 * Read the paper: page 542, first paragraph.
 		 */
-		uint32_t m_r;
+		uint32_t m_r = 0;
 
 		/// Number of nodes of the trees.
-		uint32_t m_n;
+		uint32_t m_n = 0;
 
 		/// Was the last tree generated?
 		bool m_is_last = false;
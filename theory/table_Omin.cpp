@@ -39,6 +39,8 @@
 #include <filesystem>
 #include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <chrono>
 #include <numeric>
 #include <fstream>
 #include <random>
@@ -63,6 +65,8 @@ typedef vector<uint32_t> linearrgmnt;
 
 // output progress of program into a file
 ofstream table_log;
+// number of seconds between two checkpoints of the enumeration
+double checkpoint_seconds = 600;
 // number of calls to MiniZinc (for statistics)
 uint32_t n_calls_to_MiniZinc = 0;
 
@@ -429,6 +433,103 @@ void Omin_of_all_bistar
 	}
 }
 
+// Write the state of the enumeration of the trees of n vertices into file
+// 'filename' so that it can be resumed after the last tree processed. The
+// file is first written to a temporary file and then renamed, so that a
+// checkpoint is never left half-written.
+void write_checkpoint
+(
+	const string& filename,
+	const uint32_t n,
+	const uint64_t tree_idx,
+	const all_ulab_free_trees& TreeGen,
+	const rational& Omin,
+	const vector<pair<ftree,uint64_t>>& Omin_trees,
+	const vector<pair<uint32_t, uint32_t>>& Omin_D_values
+)
+{
+	const string tmp_filename = filename + ".tmp";
+	{
+	ofstream fout;
+	fout.open(tmp_filename);
+	fout << "n= " << n << endl;
+	fout << "tree_idx= " << tree_idx << endl;
+	fout << "calls_to_MiniZinc= " << n_calls_to_MiniZinc << endl;
+	fout << "Omin= " << Omin << endl;
+	fout << "generator= ";
+	TreeGen.write_state(fout);
+
+	// every minimising tree: index, Dmin, DMax and the list of edges
+	fout << "minimising_trees= " << Omin_trees.size() << endl;
+	for (size_t s = 0; s < Omin_trees.size(); ++s) {
+		const ftree& T = Omin_trees[s].first;
+		fout << Omin_trees[s].second << " "
+			 << Omin_D_values[s].first << " "
+			 << Omin_D_values[s].second;
+		for (node u = 0; u < T.n_nodes(); ++u) {
+			for (const node v : T.get_neighbours(u)) {
+				if (u < v) { fout << " " << u << " " << v; }
+			}
+		}
+		fout << endl;
+	}
+	fout.close();
+	if (not fout) {
+		cerr << "Warning: could not write checkpoint '" << tmp_filename << "'." << endl;
+		return;
+	}
+	}
+	filesystem::rename(tmp_filename, filename);
+	table_log << "Checkpoint at tree " << tree_idx << endl;
+}
+
+// Read a checkpoint written with write_checkpoint. Returns false if the
+// file could not be read or it is not a checkpoint for trees of n vertices.
+bool read_checkpoint
+(
+	const string& filename,
+	const uint32_t n,
+	uint64_t& tree_idx,
+	all_ulab_free_trees& TreeGen,
+	rational& Omin,
+	vector<pair<ftree,uint64_t>>& Omin_trees,
+	vector<pair<uint32_t, uint32_t>>& Omin_D_values
+)
+{
+	ifstream fin;
+	fin.open(filename);
+	string field, Omin_str;
+	uint32_t checkpoint_n;
+	fin >> field >> checkpoint_n;
+	if (not fin or checkpoint_n != n) { return false; }
+	fin >> field >> tree_idx;
+	fin >> field >> n_calls_to_MiniZinc;
+	fin >> field >> Omin_str;
+	if (not fin) { return false; }
+	Omin = rational(Omin_str);
+
+	fin >> field;
+	if (not TreeGen.read_state(fin)) { return false; }
+
+	size_t num_trees;
+	fin >> field >> num_trees;
+	Omin_trees.clear();
+	Omin_D_values.clear();
+	for (size_t s = 0; s < num_trees and fin; ++s) {
+		uint64_t idx;
+		uint32_t Dmin, DMax;
+		fin >> idx >> Dmin >> DMax;
+		vector<edge> edges(n - 1);
+		for (edge& e : edges) { fin >> e.first >> e.second; }
+
+		ftree T(n);
+		T.add_edges(edges);
+		Omin_trees.push_back(make_pair(T, idx));
+		Omin_D_values.push_back(make_pair(Dmin, DMax));
+	}
+	return static_cast<bool>(fin);
+}
+
 int main(int argc, char *argv[]) {
 	if (exe_file == default_MZN_exe) {
 		cerr << "Error:" << endl;
@@ -442,17 +543,35 @@ int main(int argc, char *argv[]) {
 		823065,2144505,5623756,14828074,39299897,104636890,279793450,751065460,
 		2023443032,5469566585,14830871802
 	};
-	if (argc != 2) {
+	// continue from the last checkpoint of the enumeration, if there is one
+	bool resume = false;
+	bool wrong_parameters = (argc < 2);
+	for (int a = 2; a < argc; ++a) {
+		const string option = argv[a];
+		if (option == "--resume") { resume = true; }
+		else if (option == "--checkpoint-seconds" and a + 1 < argc) {
+			checkpoint_seconds = atof(argv[++a]);
+		}
+		else { wrong_parameters = true; }
+	}
+	if (wrong_parameters) {
 		cerr << "Error: wrong number of parameters." << endl;
-		cerr << "    ./table_Omin n" << endl;
+		cerr << "    ./table_Omin n [--resume] [--checkpoint-seconds s]" << endl;
 		cerr << "" << endl;
 		cerr << "Find the trees of 'n' vertices minimises Omega_min" << endl;
+		cerr << "" << endl;
+		cerr << "The state of the enumeration is saved every 's' seconds" << endl;
+		cerr << "(600 by default) into data/checkpoint-n, and with --resume" << endl;
+		cerr << "the enumeration continues from there." << endl;
 		return 1;
 	}
 
 	// number of vertices
 	const uint32_t n = atoi(argv[1]);
 
+	// file with the last checkpoint of the enumeration
+	const string checkpoint_file = "data/checkpoint-" + to_str2(n);
+
 	// make the command used to execute minizinc
 	make_minizinc_command(n);
 	
@@ -474,7 +593,8 @@ int main(int argc, char *argv[]) {
 	// file with tabulator-separated data
 	ofstream table_file;
 
-	table_log.open("data/log-" + to_str2(n));
+	resume = resume and filesystem::exists(checkpoint_file);
+	table_log.open("data/log-" + to_str2(n), resume ? std::ios_base::app : std::ios_base::out);
 	table_file.open("data/table_file.tsv", std::ios_base::app);
 	trees_file.open("data/MiniZinc_tree_file_dzn.txt", std::ios_base::app);
 	
@@ -504,16 +624,38 @@ int main(int argc, char *argv[]) {
 	// the trees (and their indices) that yield Omin
 	vector<pair<ftree,uint64_t>> Omin_trees;
 	
-	// Find the bistar tree that minimises Omega. Retrieve the
-	// values of Dmin and DMax that yielded such value.
-	Omin_of_all_bistar(n, Omin_trees, Omin_D_values, Omin);
-	
-	// initialise tree generator
-	TreeGen.init(n);
 	// index of the generated tree
 	uint64_t tree_idx = 0;
-	
+
+	if (resume) {
+		// the bistar trees were taken into account before the checkpoint
+		if (not read_checkpoint(checkpoint_file, n, tree_idx, TreeGen, Omin, Omin_trees, Omin_D_values)) {
+			cerr << "Error: could not read checkpoint '" << checkpoint_file << "'." << endl;
+			return 1;
+		}
+		cout << "Resuming after tree " << tree_idx << endl;
+		table_log << "Resuming after tree " << tree_idx << endl;
+	}
+	else {
+		// Find the bistar tree that minimises Omega. Retrieve the
+		// values of Dmin and DMax that yielded such value.
+		Omin_of_all_bistar(n, Omin_trees, Omin_D_values, Omin);
+
+		// initialise tree generator
+		TreeGen.init(n);
+	}
+
+	// time of the last checkpoint
+	auto last_checkpoint = chrono::steady_clock::now();
+
 	while (TreeGen.has_next()) {
+		// save the state before the next tree is generated
+		const auto now = chrono::steady_clock::now();
+		if (chrono::duration<double>(now - last_checkpoint).count() >= checkpoint_seconds) {
+			write_checkpoint(checkpoint_file, n, tree_idx, TreeGen, Omin, Omin_trees, Omin_D_values);
+			last_checkpoint = now;
+		}
+
 		TreeGen.next();
 		const ftree T = TreeGen.get_tree();
 
@@ -587,5 +729,8 @@ int main(int argc, char *argv[]) {
 	table_log.close();
 	table_file.close();
 	trees_file.close();
+
+	// the enumeration is complete: it does not need to be resumed
+	filesystem::remove(checkpoint_file);
 }
 